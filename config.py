@@ -8,12 +8,26 @@ def configure(env):
 
 
 def get_doc_classes():
-    return [
+    classes = [
         "ThreadPool",
         "ThreadPoolJob",
         "ThreadPoolExecuteJob",
+        "ThreadPoolResourceLoadJob",
+        "ThreadPoolJobGroup",
+        "ThreadPoolFuture",
+        "ThreadPoolSharedArray",
+        "ThreadPoolArrayView",
+        "ThreadPoolPipeline",
     ]
 
+    # Same as in register_types.cpp
+    import version
+
+    if version.major >= 4:
+        classes.insert(3, "ThreadPoolCallableJob")
+
+    return classes
+
 def get_doc_path():
     return "doc_classes"
 
@@ -31,8 +31,15 @@ SOFTWARE.
 #include "core/config/engine.h"
 
 #include "thread_pool.h"
+#include "thread_pool_array_view.h"
+#include "thread_pool_callable_job.h"
 #include "thread_pool_execute_job.h"
+#include "thread_pool_future.h"
 #include "thread_pool_job.h"
+#include "thread_pool_job_group.h"
+#include "thread_pool_pipeline.h"
+#include "thread_pool_resource_load_job.h"
+#include "thread_pool_shared_array.h"
 
 static ThreadPool *thread_pool = NULL;
 
@@ -40,6 +47,15 @@ void initialize_thread_pool_module(ModuleInitializationLevel p_level) {
 	if (p_level == MODULE_INITIALIZATION_LEVEL_SCENE) {
 		GDREGISTER_CLASS(ThreadPoolJob);
 		GDREGISTER_CLASS(ThreadPoolExecuteJob);
+		GDREGISTER_CLASS(ThreadPoolResourceLoadJob);
+#if VERSION_MAJOR >= 4
+		GDREGISTER_CLASS(ThreadPoolCallableJob);
+#endif
+		GDREGISTER_CLASS(ThreadPoolJobGroup);
+		GDREGISTER_CLASS(ThreadPoolFuture);
+		GDREGISTER_CLASS(ThreadPoolSharedArray);
+		GDREGISTER_CLASS(ThreadPoolArrayView);
+		GDREGISTER_CLASS(ThreadPoolPipeline);
 		GDREGISTER_CLASS(ThreadPool);
 
 		thread_pool = memnew(ThreadPool);
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_COALESCE_H
+#define TEST_THREAD_POOL_COALESCE_H
+
+#include "core/templates/vector.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_job.h"
+
+namespace TestThreadPoolCoalesce {
+
+class CoalesceRecordingJob : public ThreadPoolJob {
+	GDCLASS(CoalesceRecordingJob, ThreadPoolJob);
+
+public:
+	Vector<int> *order;
+	int id;
+
+	void _execute() {
+		order->push_back(id);
+	}
+
+	CoalesceRecordingJob() {
+		order = NULL;
+		id = 0;
+	}
+};
+
+static Ref<CoalesceRecordingJob> make_job(Vector<int> *order, const int id, const StringName &key, const float deadline = 0) {
+	Ref<CoalesceRecordingJob> job;
+	job.instantiate();
+	job->order = order;
+	job->id = id;
+	job->set_coalesce_key(key);
+	job->set_deadline(deadline);
+
+	return job;
+}
+
+// Without threads the jobs stay queued until update(), so they can be coalesced
+struct QueuedPool {
+	ThreadPool *pool;
+	bool use_threads;
+	float max_time_per_frame;
+	ThreadPool::CoalescePolicy coalesce_policy;
+
+	QueuedPool(const ThreadPool::CoalescePolicy policy) {
+		pool = ThreadPool::get_singleton();
+
+		use_threads = pool->get_use_threads();
+		max_time_per_frame = pool->get_max_time_per_frame();
+		coalesce_policy = pool->get_coalesce_policy();
+
+		pool->set_use_threads(false);
+		pool->apply_settings();
+		pool->set_max_time_per_frame(10);
+		pool->set_coalesce_policy(policy);
+	}
+
+	~QueuedPool() {
+		pool->update();
+
+		pool->set_coalesce_policy(coalesce_policy);
+		pool->set_max_time_per_frame(max_time_per_frame);
+		pool->set_use_threads(use_threads);
+		pool->apply_settings();
+	}
+};
+
+TEST_CASE("[ThreadPool] COALESCE_POLICY_KEEP_NEWEST replaces the queued job, and keeps its turn") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	QueuedPool queued(ThreadPool::COALESCE_POLICY_KEEP_NEWEST);
+
+	Vector<int> order;
+
+	Ref<CoalesceRecordingJob> old = make_job(&order, 1, "chunk");
+	Ref<CoalesceRecordingJob> other = make_job(&order, 2, StringName());
+	Ref<CoalesceRecordingJob> newest = make_job(&order, 3, "chunk");
+
+	queued.pool->add_job(old);
+	queued.pool->add_job(other);
+	queued.pool->add_job(newest);
+
+	CHECK(old->get_cancelled());
+	CHECK_FALSE(queued.pool->has_job(old));
+	CHECK(queued.pool->has_job(newest));
+	CHECK(queued.pool->get_pending_count() == 2);
+
+	queued.pool->update();
+
+	REQUIRE(order.size() == 2);
+	CHECK_MESSAGE(order[0] == 3, "The new job should run in the place of the old one.");
+	CHECK(order[1] == 2);
+}
+
+TEST_CASE("[ThreadPool] COALESCE_POLICY_KEEP_OLDEST cancels the new job") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	QueuedPool queued(ThreadPool::COALESCE_POLICY_KEEP_OLDEST);
+
+	Vector<int> order;
+
+	Ref<CoalesceRecordingJob> old = make_job(&order, 1, "chunk");
+	Ref<CoalesceRecordingJob> newest = make_job(&order, 2, "chunk");
+
+	queued.pool->add_job(old);
+	queued.pool->add_job(newest);
+
+	CHECK(newest->get_cancelled());
+	CHECK_FALSE(newest->is_queued());
+	CHECK(queued.pool->has_job(old));
+
+	queued.pool->update();
+
+	REQUIRE(order.size() == 1);
+	CHECK(order[0] == 1);
+}
+
+TEST_CASE("[ThreadPool] COALESCE_POLICY_KEEP_NEWEST keeps the earlier deadline") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	QueuedPool queued(ThreadPool::COALESCE_POLICY_KEEP_NEWEST);
+
+	Vector<int> order;
+
+	//The old job's deadline is earlier, the new one inherits it
+	Ref<CoalesceRecordingJob> old = make_job(&order, 1, "a", 10);
+	queued.pool->add_job(old);
+
+	uint64_t old_deadline = old->get_deadline_usec();
+
+	Ref<CoalesceRecordingJob> newest = make_job(&order, 2, "a", 20);
+	queued.pool->add_job(newest);
+
+	CHECK(newest->get_deadline_usec() == old_deadline);
+
+	//The new job's deadline is earlier, it moves ahead of the plain job queued before it
+	Ref<CoalesceRecordingJob> plain = make_job(&order, 3, StringName());
+	Ref<CoalesceRecordingJob> no_deadline = make_job(&order, 4, "b");
+
+	queued.pool->add_job(plain);
+	queued.pool->add_job(no_deadline);
+
+	Ref<CoalesceRecordingJob> with_deadline = make_job(&order, 5, "b", 30);
+	queued.pool->add_job(with_deadline);
+
+	CHECK(no_deadline->get_cancelled());
+	CHECK(with_deadline->get_deadline_usec() != 0);
+
+	queued.pool->update();
+
+	REQUIRE(order.size() == 3);
+	CHECK(order[0] == 2);
+	CHECK(order[1] == 5);
+	CHECK(order[2] == 3);
+}
+
+} // namespace TestThreadPoolCoalesce
+
+#endif
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_DEADLINE_H
+#define TEST_THREAD_POOL_DEADLINE_H
+
+#include "core/templates/vector.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_job.h"
+
+namespace TestThreadPoolDeadline {
+
+class DeadlineRecordingJob : public ThreadPoolJob {
+	GDCLASS(DeadlineRecordingJob, ThreadPoolJob);
+
+public:
+	Vector<int> *order;
+	int id;
+
+	void _execute() {
+		order->push_back(id);
+	}
+
+	DeadlineRecordingJob() {
+		order = NULL;
+		id = 0;
+	}
+};
+
+static Ref<DeadlineRecordingJob> make_job(Vector<int> *order, const int id, const float deadline) {
+	Ref<DeadlineRecordingJob> job;
+	job.instantiate();
+	job->order = order;
+	job->id = id;
+	job->set_deadline(deadline);
+
+	return job;
+}
+
+TEST_CASE("[ThreadPool] Jobs with a deadline run earliest deadline first, before the other jobs") {
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	//Without threads update() runs the queue in order on the calling thread
+	bool use_threads = pool->get_use_threads();
+	float max_time_per_frame = pool->get_max_time_per_frame();
+
+	pool->set_use_threads(false);
+	pool->apply_settings();
+	pool->set_max_time_per_frame(10);
+
+	int total_missed_deadline_count = pool->get_total_missed_deadline_count();
+
+	Vector<int> order;
+
+	pool->add_job(make_job(&order, 0, 0));
+	pool->add_job(make_job(&order, 3, 30));
+	pool->add_job(make_job(&order, 1, 10));
+	pool->add_job(make_job(&order, 2, 20));
+
+	CHECK(pool->get_pending_count() == 4);
+
+	pool->update();
+
+	REQUIRE(order.size() == 4);
+	CHECK(order[0] == 1);
+	CHECK(order[1] == 2);
+	CHECK(order[2] == 3);
+	CHECK_MESSAGE(order[3] == 0, "Jobs without a deadline should run after the ones with a deadline.");
+
+	CHECK_FALSE(pool->is_working());
+	CHECK(pool->get_total_missed_deadline_count() == total_missed_deadline_count);
+
+	pool->set_max_time_per_frame(max_time_per_frame);
+	pool->set_use_threads(use_threads);
+	pool->apply_settings();
+}
+
+} // namespace TestThreadPoolDeadline
+
+#endif
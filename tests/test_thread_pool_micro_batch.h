@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_MICRO_BATCH_H
+#define TEST_THREAD_POOL_MICRO_BATCH_H
+
+#include "core/os/os.h"
+#include "core/templates/safe_refcount.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_job.h"
+
+namespace TestThreadPoolMicroBatch {
+
+class MicroCountingJob : public ThreadPoolJob {
+	GDCLASS(MicroCountingJob, ThreadPoolJob);
+
+public:
+	SafeNumeric<int> *runs;
+
+	void _execute() {
+		runs->increment();
+	}
+
+	MicroCountingJob() {
+		runs = NULL;
+		set_micro(true);
+	}
+};
+
+static Ref<MicroCountingJob> make_job(SafeNumeric<int> *runs) {
+	Ref<MicroCountingJob> job;
+	job.instantiate();
+	job->runs = runs;
+
+	return job;
+}
+
+static void wait_for_pool(ThreadPool *pool) {
+	while (pool->is_working()) {
+		OS::get_singleton()->delay_usec(100);
+	}
+}
+
+TEST_CASE("[ThreadPool] Micro jobs run in batches, including the last partial one") {
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	//Micro jobs are only batched when threads are used
+	if (!pool->get_use_threads()) {
+		return;
+	}
+
+	int batch_size = pool->get_micro_batch_size();
+	pool->set_micro_batch_size(4);
+
+	SafeNumeric<int> runs;
+	const int job_count = 10;
+
+	for (int i = 0; i < job_count; ++i) {
+		pool->add_job(make_job(&runs));
+	}
+
+	//The last two jobs are flushed by the timer thread, when the batch window passes
+	wait_for_pool(pool);
+
+	CHECK(runs.get() == job_count);
+	CHECK(pool->get_pending_count() == 0);
+
+	pool->set_micro_batch_size(batch_size);
+}
+
+TEST_CASE("[ThreadPool] Micro jobs can be cancelled, while their batch is still open") {
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	if (!pool->get_use_threads()) {
+		return;
+	}
+
+	int batch_size = pool->get_micro_batch_size();
+	float batch_window = pool->get_micro_batch_window();
+
+	//Big and long enough, so the batch stays open during the test
+	pool->set_micro_batch_size(100);
+	pool->set_micro_batch_window(10);
+
+	SafeNumeric<int> runs;
+
+	Ref<MicroCountingJob> cancelled = make_job(&runs);
+	Ref<MicroCountingJob> kept = make_job(&runs);
+
+	pool->add_job(cancelled);
+	pool->add_job(kept);
+
+	CHECK(pool->has_job(cancelled));
+	CHECK(pool->get_pending_count() == 2);
+
+	pool->cancel_job(cancelled);
+
+	CHECK_FALSE(pool->has_job(cancelled));
+	CHECK(pool->get_pending_count() == 1);
+
+	//Reaching the size flushes the batch
+	pool->set_micro_batch_size(1);
+	wait_for_pool(pool);
+
+	CHECK(runs.get() == 1);
+
+	pool->set_micro_batch_size(batch_size);
+	pool->set_micro_batch_window(batch_window);
+}
+
+} // namespace TestThreadPoolMicroBatch
+
+#endif
@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_PARALLEL_H
+#define TEST_THREAD_POOL_PARALLEL_H
+
+#include "core/templates/vector.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool_parallel.h"
+
+namespace TestThreadPoolParallel {
+
+TEST_CASE("[ThreadPoolParallel] parallel_for visits every index exactly once") {
+	const int count = 1000;
+
+	Vector<int> visits;
+	visits.resize(count);
+
+	int *ptr = visits.ptrw();
+
+	for (int i = 0; i < count; ++i) {
+		ptr[i] = 0;
+	}
+
+	//Small chunks, so there are a lot of tasks, and the last one is partial
+	ThreadPoolParallel::parallel_for(
+			count, [ptr](const int from, const int to) {
+				for (int i = from; i < to; ++i) {
+					++ptr[i];
+				}
+			},
+			7);
+
+	for (int i = 0; i < count; ++i) {
+		CHECK_MESSAGE(visits[i] == 1, "Every index should be visited once.");
+	}
+}
+
+TEST_CASE("[ThreadPoolParallel] map, reduce and inclusive_scan match the serial results") {
+	const int count = 5000;
+
+	Vector<int> data;
+	data.resize(count);
+
+	for (int i = 0; i < count; ++i) {
+		data.write[i] = i % 17;
+	}
+
+	Vector<int> mapped;
+	mapped.resize(count);
+
+	ThreadPoolParallel::map(data.ptr(), mapped.ptrw(), count, [](const int value) {
+		return value * 3;
+	});
+
+	int expected_sum = 0;
+
+	for (int i = 0; i < count; ++i) {
+		CHECK(mapped[i] == data[i] * 3);
+		expected_sum += data[i];
+	}
+
+	int sum = ThreadPoolParallel::reduce(data.ptr(), count, 0, [](const int a, const int b) {
+		return a + b;
+	});
+
+	CHECK(sum == expected_sum);
+
+	Vector<int> scanned;
+	scanned.resize(count);
+
+	ThreadPoolParallel::inclusive_scan(data.ptr(), scanned.ptrw(), count, 0, [](const int a, const int b) {
+		return a + b;
+	});
+
+	int running = 0;
+
+	for (int i = 0; i < count; ++i) {
+		running += data[i];
+		CHECK_MESSAGE(scanned[i] == running, "Chunks after the first one should start from the sum of the previous ones.");
+	}
+}
+
+TEST_CASE("[ThreadPoolParallel] sort handles inputs split into multiple chunks") {
+	//More than one chunk when threads are used (chunks are at least MIN_CHUNK_ITEMS long), and not a multiple of it
+	const int count = ThreadPoolParallel::MIN_CHUNK_ITEMS * 5 + 123;
+
+	Vector<int> data;
+	data.resize(count);
+
+	for (int i = 0; i < count; ++i) {
+		//Reversed, with duplicates
+		data.write[i] = (count - i) / 3;
+	}
+
+	ThreadPoolParallel::sort(data.ptrw(), count);
+
+	for (int i = 1; i < count; ++i) {
+		CHECK_MESSAGE(data[i - 1] <= data[i], "The result should be sorted.");
+	}
+
+	CHECK(data[0] == 0);
+	CHECK(data[count - 1] == count / 3);
+}
+
+} // namespace TestThreadPoolParallel
+
+#endif
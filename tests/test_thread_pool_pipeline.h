@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TEST_THREAD_POOL_PIPELINE_H
+#define TEST_THREAD_POOL_PIPELINE_H
+
+#include "core/object/class_db.h"
+#include "core/os/mutex.h"
+#include "core/templates/vector.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool_pipeline.h"
+
+namespace TestThreadPoolPipeline {
+
+class PipelineStages : public Object {
+	GDCLASS(PipelineStages, Object);
+
+public:
+	Mutex lock;
+	Vector<int> recorded;
+
+	Variant double_item(const Variant &item) {
+		return static_cast<int>(item) * 2;
+	}
+
+	Variant record_item(const Variant &item) {
+		lock.lock();
+		recorded.push_back(item);
+		lock.unlock();
+
+		return item;
+	}
+
+protected:
+	static void _bind_methods() {
+		ClassDB::bind_method(D_METHOD("double_item", "item"), &PipelineStages::double_item);
+		ClassDB::bind_method(D_METHOD("record_item", "item"), &PipelineStages::record_item);
+	}
+};
+
+TEST_CASE("[ThreadPoolPipeline] A serial stage after a parallel stage gets the items in push order") {
+	GDREGISTER_CLASS(PipelineStages);
+
+	const int item_count = 64;
+
+	PipelineStages *stages = memnew(PipelineStages);
+
+	Ref<ThreadPoolPipeline> pipeline;
+	pipeline.instantiate();
+	pipeline->set_max_tokens(item_count);
+
+	pipeline->add_stage(stages, "double_item");
+	pipeline->add_stage(stages, "record_item", true);
+
+	for (int i = 0; i < item_count; ++i) {
+		CHECK(pipeline->push(i));
+	}
+
+	//Used to hang, the serial stage got sequence 0 for every item
+	pipeline->wait();
+
+	REQUIRE(stages->recorded.size() == item_count);
+
+	for (int i = 0; i < item_count; ++i) {
+		CHECK_MESSAGE(stages->recorded[i] == i * 2, "The serial stage should run the items in push order.");
+	}
+
+	for (int i = 0; i < item_count; ++i) {
+		CHECK(static_cast<int>(pipeline->pop()) == i * 2);
+	}
+
+	CHECK(pipeline->get_in_flight_count() == 0);
+
+	memdelete(stages);
+}
+
+} // namespace TestThreadPoolPipeline
+
+#endif
@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_QUEUE_CAPACITY_H
+#define TEST_THREAD_POOL_QUEUE_CAPACITY_H
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_job.h"
+
+namespace TestThreadPoolQueueCapacity {
+
+class CapacityTestJob : public ThreadPoolJob {
+	GDCLASS(CapacityTestJob, ThreadPoolJob);
+
+public:
+	void _execute() {
+	}
+};
+
+// Without threads nothing takes jobs from the queue until update(), so it can be filled up
+struct BoundedPool {
+	ThreadPool *pool;
+	bool use_threads;
+	float max_time_per_frame;
+	int queue_capacity;
+	ThreadPool::QueueFullPolicy queue_full_policy;
+
+	BoundedPool(const int capacity, const ThreadPool::QueueFullPolicy policy) {
+		pool = ThreadPool::get_singleton();
+
+		use_threads = pool->get_use_threads();
+		max_time_per_frame = pool->get_max_time_per_frame();
+		queue_capacity = pool->get_queue_capacity();
+		queue_full_policy = pool->get_queue_full_policy();
+
+		pool->set_use_threads(false);
+		pool->apply_settings();
+		pool->set_queue_capacity(capacity);
+		pool->set_queue_full_policy(policy);
+	}
+
+	~BoundedPool() {
+		//Runs the jobs that are left
+		pool->set_max_time_per_frame(10);
+		pool->update();
+
+		pool->set_max_time_per_frame(max_time_per_frame);
+		pool->set_queue_capacity(queue_capacity);
+		pool->set_queue_full_policy(queue_full_policy);
+		pool->set_use_threads(use_threads);
+		pool->apply_settings();
+	}
+};
+
+static Ref<ThreadPoolJob> make_job(const int priority = 0) {
+	Ref<CapacityTestJob> job;
+	job.instantiate();
+	job->set_priority(priority);
+
+	return job;
+}
+
+TEST_CASE("[ThreadPool] QUEUE_FULL_POLICY_FAIL rejects jobs when the queue is full") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	BoundedPool bounded(2, ThreadPool::QUEUE_FULL_POLICY_FAIL);
+
+	Ref<ThreadPoolJob> first = make_job();
+	Ref<ThreadPoolJob> second = make_job();
+	Ref<ThreadPoolJob> third = make_job();
+
+	CHECK(bounded.pool->add_job_with_policy(first, ThreadPool::QUEUE_FULL_POLICY_FAIL));
+	CHECK(bounded.pool->add_job_with_policy(second, ThreadPool::QUEUE_FULL_POLICY_FAIL));
+	CHECK_FALSE(bounded.pool->add_job_with_policy(third, ThreadPool::QUEUE_FULL_POLICY_FAIL));
+
+	CHECK(third->get_cancelled());
+	CHECK_FALSE(third->is_queued());
+	CHECK(bounded.pool->get_pending_count() == 2);
+}
+
+TEST_CASE("[ThreadPool] QUEUE_FULL_POLICY_BLOCK fails instead of blocking, when nothing could drain the queue") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	BoundedPool bounded(1, ThreadPool::QUEUE_FULL_POLICY_BLOCK);
+
+	Ref<ThreadPoolJob> first = make_job();
+	Ref<ThreadPoolJob> second = make_job();
+
+	CHECK(bounded.pool->add_job_with_policy(first, ThreadPool::QUEUE_FULL_POLICY_BLOCK));
+	CHECK_FALSE(bounded.pool->add_job_with_policy(second, ThreadPool::QUEUE_FULL_POLICY_BLOCK));
+
+	CHECK(second->get_cancelled());
+}
+
+TEST_CASE("[ThreadPool] QUEUE_FULL_POLICY_DROP_OLDEST makes room by dropping the oldest job") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	BoundedPool bounded(2, ThreadPool::QUEUE_FULL_POLICY_DROP_OLDEST);
+
+	Ref<ThreadPoolJob> first = make_job();
+	Ref<ThreadPoolJob> second = make_job();
+	Ref<ThreadPoolJob> third = make_job();
+
+	bounded.pool->add_job(first);
+	bounded.pool->add_job(second);
+	bounded.pool->add_job(third);
+
+	CHECK(first->get_cancelled());
+	CHECK_FALSE(bounded.pool->has_job(first));
+
+	CHECK(bounded.pool->has_job(second));
+	CHECK(bounded.pool->has_job(third));
+	CHECK(bounded.pool->get_pending_count() == 2);
+}
+
+TEST_CASE("[ThreadPool] QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY drops the least important job") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	BoundedPool bounded(2, ThreadPool::QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY);
+
+	Ref<ThreadPoolJob> low = make_job(1);
+	Ref<ThreadPoolJob> high = make_job(5);
+
+	bounded.pool->add_job(high);
+	bounded.pool->add_job(low);
+
+	Ref<ThreadPoolJob> medium = make_job(3);
+
+	CHECK(bounded.pool->add_job_with_policy(medium, ThreadPool::QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY));
+	CHECK(low->get_cancelled());
+	CHECK(bounded.pool->has_job(high));
+	CHECK(bounded.pool->has_job(medium));
+
+	//The new job is the least important one, so it's the one that gets rejected
+	Ref<ThreadPoolJob> lowest = make_job(0);
+
+	CHECK_FALSE(bounded.pool->add_job_with_policy(lowest, ThreadPool::QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY));
+	CHECK(lowest->get_cancelled());
+	CHECK(bounded.pool->get_pending_count() == 2);
+}
+
+} // namespace TestThreadPoolQueueCapacity
+
+#endif
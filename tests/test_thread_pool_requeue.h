@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TEST_THREAD_POOL_REQUEUE_H
+#define TEST_THREAD_POOL_REQUEUE_H
+
+#include "core/os/os.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_job.h"
+
+namespace TestThreadPoolRequeue {
+
+// Waits once, like a job polling something outside of the pool
+class WaitingJob : public ThreadPoolJob {
+	GDCLASS(WaitingJob, ThreadPoolJob);
+
+public:
+	int runs;
+
+	void _execute() {
+		++runs;
+
+		if (runs == 1) {
+			requeue(0.001);
+			return;
+		}
+
+		set_complete(true);
+	}
+
+	WaitingJob() {
+		runs = 0;
+		set_complete(false);
+	}
+};
+
+// Without threads requeued jobs only come back in update(), so every step can be checked
+struct RequeuePool {
+	ThreadPool *pool;
+	bool use_threads;
+	float max_time_per_frame;
+
+	RequeuePool() {
+		pool = ThreadPool::get_singleton();
+
+		use_threads = pool->get_use_threads();
+		max_time_per_frame = pool->get_max_time_per_frame();
+
+		pool->set_use_threads(false);
+		pool->apply_settings();
+		pool->set_max_time_per_frame(10);
+	}
+
+	~RequeuePool() {
+		pool->update();
+
+		pool->set_max_time_per_frame(max_time_per_frame);
+		pool->set_use_threads(use_threads);
+		pool->apply_settings();
+	}
+};
+
+TEST_CASE("[ThreadPool] A requeued job runs again after its delay, and doesn't hold up the frame") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	RequeuePool requeue_pool;
+
+	Ref<WaitingJob> waiting;
+	waiting.instantiate();
+	Ref<WaitingJob> other;
+	other.instantiate();
+
+	requeue_pool.pool->add_job(waiting);
+	requeue_pool.pool->add_job(other);
+
+	requeue_pool.pool->update();
+
+	CHECK(waiting->runs == 1);
+	CHECK_MESSAGE(other->runs == 1, "The job behind the requeued one should still run in the same frame.");
+	CHECK(waiting->get_requeued());
+	CHECK(waiting->is_queued());
+	CHECK(requeue_pool.pool->has_job(waiting));
+	CHECK_FALSE(waiting->get_complete());
+
+	OS::get_singleton()->delay_usec(5000);
+	requeue_pool.pool->update();
+
+	CHECK(waiting->runs == 2);
+	CHECK(waiting->get_complete());
+	CHECK_FALSE(waiting->get_requeued());
+	CHECK_FALSE(requeue_pool.pool->has_job(waiting));
+}
+
+TEST_CASE("[ThreadPool] Cancelling a requeued job removes it") {
+	REQUIRE(ThreadPool::get_singleton());
+
+	RequeuePool requeue_pool;
+
+	Ref<WaitingJob> waiting;
+	waiting.instantiate();
+
+	requeue_pool.pool->add_job(waiting);
+	requeue_pool.pool->update();
+
+	REQUIRE(waiting->get_requeued());
+
+	requeue_pool.pool->cancel_job(waiting);
+
+	CHECK(waiting->get_cancelled());
+	CHECK_FALSE(waiting->get_requeued());
+	CHECK_FALSE(requeue_pool.pool->has_job(waiting));
+
+	OS::get_singleton()->delay_usec(5000);
+	requeue_pool.pool->update();
+
+	CHECK_MESSAGE(waiting->runs == 1, "A cancelled job shouldn't run again.");
+}
+
+} // namespace TestThreadPoolRequeue
+
+#endif
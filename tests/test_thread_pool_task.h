@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_TASK_H
+#define TEST_THREAD_POOL_TASK_H
+
+#include "core/templates/safe_refcount.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool.h"
+#include "../thread_pool_task.h"
+
+namespace TestThreadPoolTask {
+
+// Bigger than ThreadPoolTask::INLINE_SIZE, so it's stored on the heap. Counts its live copies.
+struct LargeCallable {
+	SafeNumeric<int> *runs;
+	SafeNumeric<int> *alive;
+	uint64_t padding[8];
+
+	void operator()() {
+		runs->increment();
+	}
+
+	LargeCallable(SafeNumeric<int> *p_runs, SafeNumeric<int> *p_alive) {
+		runs = p_runs;
+		alive = p_alive;
+		alive->increment();
+
+		for (int i = 0; i < 8; ++i) {
+			padding[i] = i;
+		}
+	}
+
+	LargeCallable(const LargeCallable &other) {
+		runs = other.runs;
+		alive = other.alive;
+		alive->increment();
+
+		for (int i = 0; i < 8; ++i) {
+			padding[i] = other.padding[i];
+		}
+	}
+
+	~LargeCallable() {
+		alive->decrement();
+	}
+};
+
+TEST_CASE("[ThreadPool] An empty task future is done") {
+	ThreadPoolTaskFuture future;
+
+	CHECK_FALSE(future.is_valid());
+	CHECK(future.is_done());
+}
+
+TEST_CASE("[ThreadPool] Submitted tasks run, and their futures resolve") {
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	const int task_count = 100;
+
+	SafeNumeric<int> runs;
+	ThreadPoolTaskFuture futures[task_count];
+
+	for (int i = 0; i < task_count; ++i) {
+		futures[i] = pool->submit([&runs]() {
+			runs.increment();
+		});
+
+		CHECK(futures[i].is_valid());
+	}
+
+	for (int i = 0; i < task_count; ++i) {
+		futures[i].wait();
+		CHECK(futures[i].is_done());
+	}
+
+	CHECK(runs.get() == task_count);
+}
+
+TEST_CASE("[ThreadPool] Callables too big to be stored inline run and get destroyed") {
+	static_assert(sizeof(LargeCallable) > ThreadPoolTask::INLINE_SIZE, "LargeCallable has to be stored on the heap.");
+
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	SafeNumeric<int> runs;
+	SafeNumeric<int> alive;
+
+	ThreadPoolTaskFuture future = pool->submit(LargeCallable(&runs, &alive));
+	future.wait();
+
+	CHECK(runs.get() == 1);
+	CHECK_MESSAGE(alive.get() == 0, "The heap copy of the callable should be freed after it ran.");
+}
+
+TEST_CASE("[ThreadPool] A finished future stays done after its slot is reused") {
+	ThreadPool *pool = ThreadPool::get_singleton();
+	REQUIRE(pool);
+
+	ThreadPoolTaskFuture first = pool->submit([]() {});
+	first.wait();
+
+	//Slots are recycled, the next task most likely gets the same one
+	SafeNumeric<int> runs;
+
+	ThreadPoolTaskFuture second = pool->submit([&runs]() {
+		runs.increment();
+	});
+
+	CHECK(first.is_done());
+
+	second.wait();
+
+	CHECK(second.is_done());
+	CHECK(runs.get() == 1);
+}
+
+} // namespace TestThreadPoolTask
+
+#endif
@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef TEST_THREAD_POOL_TIMER_WHEEL_H
+#define TEST_THREAD_POOL_TIMER_WHEEL_H
+
+#include "core/templates/list.h"
+
+#include "tests/test_macros.h"
+
+#include "../thread_pool_job.h"
+#include "../thread_pool_timer_wheel.h"
+
+namespace TestThreadPoolTimerWheel {
+
+TEST_CASE("[ThreadPoolTimerWheel] A delayed timer expires on its tick") {
+	ThreadPoolTimerWheel wheel;
+
+	Ref<ThreadPoolJob> job;
+	job.instantiate();
+
+	wheel.add(job, 10, 0);
+
+	CHECK(wheel.size() == 1);
+	CHECK(wheel.has(job));
+	CHECK(wheel.get_next_expiry() == 10);
+
+	List<ThreadPoolTimerWheel::Timer> expired;
+
+	wheel.advance(9, &expired);
+	CHECK(expired.size() == 0);
+
+	wheel.advance(10, &expired);
+	REQUIRE(expired.size() == 1);
+	CHECK(expired.front()->get().job == job);
+
+	CHECK(wheel.empty());
+	CHECK(wheel.get_next_expiry() == 0);
+}
+
+TEST_CASE("[ThreadPoolTimerWheel] Timers past the first level cascade down and expire on time") {
+	ThreadPoolTimerWheel wheel;
+
+	Ref<ThreadPoolJob> job;
+	job.instantiate();
+
+	const uint64_t expires = ThreadPoolTimerWheel::SLOT_COUNT * ThreadPoolTimerWheel::SLOT_COUNT + 5;
+
+	wheel.add(job, expires, 0);
+
+	CHECK(wheel.get_next_expiry() == expires);
+
+	List<ThreadPoolTimerWheel::Timer> expired;
+
+	wheel.advance(expires - 1, &expired);
+	CHECK(expired.size() == 0);
+	CHECK(wheel.has(job));
+
+	wheel.advance(expires, &expired);
+	CHECK(expired.size() == 1);
+	CHECK(wheel.empty());
+}
+
+TEST_CASE("[ThreadPoolTimerWheel] Repeating timers are rescheduled until their job is cancelled") {
+	ThreadPoolTimerWheel wheel;
+
+	Ref<ThreadPoolJob> job;
+	job.instantiate();
+
+	wheel.add(job, 4, 4);
+
+	List<ThreadPoolTimerWheel::Timer> expired;
+
+	wheel.advance(12, &expired);
+	CHECK(expired.size() == 3);
+	CHECK(wheel.size() == 1);
+	CHECK(wheel.get_next_expiry() == 16);
+
+	job->set_cancelled(true);
+
+	expired.clear();
+	wheel.advance(16, &expired);
+	CHECK(expired.size() == 0);
+	CHECK(wheel.empty());
+}
+
+TEST_CASE("[ThreadPoolTimerWheel] Removed timers don't expire, the earliest one is reported") {
+	ThreadPoolTimerWheel wheel;
+
+	Ref<ThreadPoolJob> first;
+	first.instantiate();
+
+	Ref<ThreadPoolJob> second;
+	second.instantiate();
+
+	wheel.add(second, 200, 0);
+	wheel.add(first, 3, 0);
+
+	CHECK(wheel.get_next_expiry() == 3);
+
+	CHECK(wheel.remove(first));
+	CHECK_FALSE(wheel.remove(first));
+	CHECK(wheel.get_next_expiry() == 200);
+
+	List<ThreadPoolTimerWheel::Timer> expired;
+
+	wheel.advance(200, &expired);
+	REQUIRE(expired.size() == 1);
+	CHECK(expired.front()->get().job == second);
+}
+
+} // namespace TestThreadPoolTimerWheel
+
+#endif
@@ -37,8 +37,20 @@ SOFTWARE.
 #include "core/os/os.h"
 #include "scene/main/scene_tree.h"
 
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "thread_pool_parallel.h"
+#include "thread_pool_resource_load_job.h"
+
 #include "core/version.h"
 
+#include <chrono>
+
 #if VERSION_MAJOR >= 4
 #define CONNECT(sig, obj, target_method_class, method) connect(sig, callable_mp(obj, &target_method_class::method))
 #define DISCONNECT(sig, obj, target_method_class, method) disconnect(sig, callable_mp(obj, &target_method_class::method))
@@ -50,6 +62,16 @@ SOFTWARE.
 #endif
 
 ThreadPool *ThreadPool::_instance;
+thread_local ThreadPool::ThreadPoolScratch *ThreadPool::_current_scratch = NULL;
+thread_local int ThreadPool::_current_worker_index = -1;
+
+static _FORCE_INLINE_ bool _is_main_thread() {
+#if VERSION_MAJOR < 4
+	return Thread::get_caller_id() == Thread::get_main_id();
+#else
+	return Thread::is_main_thread();
+#endif
+}
 
 ThreadPool *ThreadPool::get_singleton() {
 	return _instance;
@@ -80,301 +102,2465 @@ void ThreadPool::set_thread_fallback_count(const int value) {
 	_dirty = true;
 }
 
-float ThreadPool::get_max_time_per_frame() const {
-	return _max_time_per_frame;
+bool ThreadPool::get_use_engine_worker_pool() const {
+	return _use_engine_worker_pool_new;
+}
+void ThreadPool::set_use_engine_worker_pool(const bool value) {
+#if VERSION_MAJOR < 4
+	ERR_FAIL_COND_MSG(value, "ThreadPool: The engine's WorkerThreadPool is only available in Godot 4!");
+#endif
+
+	// Will be applied later in update, same as use_threads
+	_use_engine_worker_pool_new = value;
+	_dirty = true;
+}
+
+float ThreadPool::get_max_time_per_frame() const {
+	return _max_time_per_frame;
+}
+void ThreadPool::set_max_time_per_frame(const float value) {
+	_max_time_per_frame = value;
+}
+
+float ThreadPool::get_max_work_per_frame_percent() const {
+	return _max_work_per_frame_percent;
+}
+void ThreadPool::set_max_work_per_frame_percent(const float value) {
+	_max_work_per_frame_percent = value;
+
+	apply_max_work_per_frame_percent();
+}
+
+float ThreadPool::get_target_fps() const {
+	return _target_fps;
+}
+void ThreadPool::set_target_fps(const float value) {
+	_target_fps = value;
+
+	apply_max_work_per_frame_percent();
+}
+
+void ThreadPool::apply_max_work_per_frame_percent() {
+	_max_time_per_frame = (1.0 / _target_fps) * (_max_work_per_frame_percent / 100.0);
+}
+
+int ThreadPool::get_missed_deadline_count() const {
+	return _missed_deadline_count;
+}
+
+int ThreadPool::get_total_missed_deadline_count() const {
+	return _total_missed_deadline_count;
+}
+
+bool ThreadPool::is_working() const {
+	return _active_count.get() > 0 || _pending_count.get() > 0;
+}
+
+bool ThreadPool::is_working_no_lock() const {
+	return is_working();
+}
+
+int ThreadPool::get_pending_count() const {
+	return _pending_count.get();
+}
+
+int ThreadPool::get_active_count() const {
+	return _active_count.get();
+}
+
+bool ThreadPool::has_job(const Ref<ThreadPoolJob> &job) {
+	_lock_pool();
+
+	bool found = _has_job_no_lock(job);
+
+	_unlock_pool();
+
+	return found;
+}
+
+void ThreadPool::add_job(const Ref<ThreadPoolJob> &job) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	add_job_with_policy(job, _queue_full_policy);
+}
+
+bool ThreadPool::add_job_with_policy(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy) {
+	ERR_FAIL_COND_V(!job.is_valid(), false);
+
+	_lock_pool();
+
+	bool added = _add_job_no_lock(job, policy);
+
+	_unlock_pool();
+
+	return added;
+}
+
+//Expects the lock to be held, QUEUE_FULL_POLICY_BLOCK releases it while waiting
+bool ThreadPool::_add_job_no_lock(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy) {
+	//Checked under the lock, otherwise a worker could queue the same job between the check and the insert
+	ERR_FAIL_COND_V_MSG(job->is_queued(), false, "ThreadPool: The job is already queued!");
+
+	_prepare_job(job);
+
+	return _add_prepared_job_no_lock(job, policy);
+}
+
+//Same as _add_job_no_lock, for jobs that were already added once (their deadline is kept)
+bool ThreadPool::_add_prepared_job_no_lock(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy) {
+	//Categories and coalescing need the queue, so these jobs go down the normal path even if they are micro
+	if (job->get_micro() && _use_threads && job->get_category() == StringName() && job->get_coalesce_key() == StringName()) {
+		_add_micro_job_no_lock(job);
+		return true;
+	}
+
+	if (job->get_coalesce_key() != StringName() && _coalesce_job_no_lock(job)) {
+		return true;
+	}
+
+	if (_assign_to_idle_context_no_lock(job)) {
+		return true;
+	}
+
+	while (_queue_capacity > 0 && _get_queued_job_count_no_lock() >= _queue_capacity) {
+		if (policy == QUEUE_FULL_POLICY_BLOCK && _can_block_on_full_queue_no_lock()) {
+			//Woken by _wake_blocked_producer_no_lock, when a job leaves the queue
+			++_blocked_producer_count;
+
+			_unlock_pool();
+
+			_blocked_producer_semaphore->wait();
+
+			_lock_pool();
+
+			//A job with the same key might have been queued while this one waited
+			if (job->get_coalesce_key() != StringName() && _coalesce_job_no_lock(job)) {
+				return true;
+			}
+
+			if (_assign_to_idle_context_no_lock(job)) {
+				return true;
+			}
+
+			continue;
+		}
+
+		ThreadPoolJob *dropped = NULL;
+
+		if (policy == QUEUE_FULL_POLICY_DROP_OLDEST) {
+			//Jobs with a deadline are kept if possible
+			dropped = _queue.empty() ? _deadline_queue.front() : _queue.front();
+		} else if (policy == QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY) {
+			ThreadPoolJobQueue *queues[] = { &_queue, &_deadline_queue };
+
+			for (int i = 0; i < 2; ++i) {
+				for (ThreadPoolJob *j = queues[i]->front(); j; j = j->get_queue_next()) {
+					if (!dropped || j->get_priority() < dropped->get_priority()) {
+						dropped = j;
+					}
+				}
+			}
+
+			//The new job is the least important one
+			if (dropped && dropped->get_priority() >= job->get_priority()) {
+				dropped = NULL;
+			}
+		}
+
+		//QUEUE_FULL_POLICY_FAIL, or QUEUE_FULL_POLICY_BLOCK when blocking could deadlock
+		if (!dropped) {
+			_discard_job_no_lock(job);
+			return false;
+		}
+
+		_discard_job_no_lock(Ref<ThreadPoolJob>(dropped));
+	}
+
+	return _enqueue_job_no_lock(job);
+}
+
+int ThreadPool::get_queue_capacity() const {
+	return _queue_capacity;
+}
+void ThreadPool::set_queue_capacity(const int value) {
+	_lock_pool();
+
+	_queue_capacity = value;
+	_update_queue_pressure_no_lock();
+
+	_unlock_pool();
+}
+
+ThreadPool::QueueFullPolicy ThreadPool::get_queue_full_policy() const {
+	return _queue_full_policy;
+}
+void ThreadPool::set_queue_full_policy(const QueueFullPolicy value) {
+	_queue_full_policy = value;
+}
+
+ThreadPool::CoalescePolicy ThreadPool::get_coalesce_policy() const {
+	return _coalesce_policy;
+}
+void ThreadPool::set_coalesce_policy(const CoalescePolicy value) {
+	_coalesce_policy = value;
+}
+
+int ThreadPool::get_micro_batch_size() const {
+	return _micro_batch_size;
+}
+void ThreadPool::set_micro_batch_size(const int value) {
+	ERR_FAIL_COND(value <= 0);
+
+	_lock_pool();
+
+	_micro_batch_size = value;
+
+	if (_micro_batch && _micro_batch->size() >= _micro_batch_size) {
+		_flush_micro_batch_no_lock();
+	}
+
+	_unlock_pool();
+}
+
+float ThreadPool::get_micro_batch_window() const {
+	return _micro_batch_window;
+}
+void ThreadPool::set_micro_batch_window(const float value) {
+	_micro_batch_window = value;
+}
+
+int ThreadPool::get_category_limit(const StringName &category) const {
+	_lock_pool();
+
+	const CategoryState *state = _categories.getptr(category);
+	int limit = state ? state->limit : 0;
+
+	_unlock_pool();
+
+	return limit;
+}
+void ThreadPool::set_category_limit(const StringName &category, const int max_running) {
+	ERR_FAIL_COND(category == StringName());
+
+	_lock_pool();
+
+	CategoryState &state = _categories[category];
+
+	if (state.limit <= 0 && max_running > 0) {
+		++_limited_category_count;
+	} else if (state.limit > 0 && max_running <= 0) {
+		--_limited_category_count;
+	}
+
+	state.limit = max_running;
+
+	//A higher limit can make queued jobs runnable
+	_dispatch_to_idle_contexts_no_lock();
+
+	_unlock_pool();
+}
+
+int ThreadPool::get_category_running_count(const StringName &category) const {
+	_lock_pool();
+
+	const CategoryState *state = _categories.getptr(category);
+	int running = state ? state->running : 0;
+
+	_unlock_pool();
+
+	return running;
+}
+
+void ThreadPool::add_job_to_worker(const Ref<ThreadPoolJob> &job, const int worker_index) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	_lock_pool();
+
+	//The mailboxes only support one producer, which is the main thread
+	if (!_use_threads || worker_index < 0 || worker_index >= _context_count || !_is_main_thread()) {
+		_add_job_no_lock(job, _queue_full_policy);
+
+		_unlock_pool();
+		return;
+	}
+
+	//Checked under the lock, as in _add_job_no_lock
+	if (job->is_queued()) {
+		_unlock_pool();
+		ERR_FAIL_MSG("ThreadPool: The job is already queued!");
+	}
+
+	_prepare_job(job);
+
+	ThreadPoolContext *context = &_contexts[worker_index];
+
+	//Marked, so has_job and cancel_job see the job until the worker picks it up
+	job->reference();
+	job->set_in_mailbox(true);
+	_pending_count.increment();
+
+	if (!context->mailbox.push(job.ptr())) {
+		_pending_count.decrement();
+		job->set_in_mailbox(false);
+		job->unreference();
+
+		_add_job_no_lock(job, _queue_full_policy);
+
+		_unlock_pool();
+		return;
+	}
+
+	_wake_context(context);
+
+	_unlock_pool();
+}
+
+Ref<ThreadPoolFuture> ThreadPool::add_job_with_future(const Ref<ThreadPoolJob> &job) {
+	ERR_FAIL_COND_V(!job.is_valid(), Ref<ThreadPoolFuture>());
+	ERR_FAIL_COND_V_MSG(job->get_future().is_valid(), job->get_future(), "ThreadPool: The job already has a pending future!");
+
+	//Has to be set before the job is added, as it can finish right away
+	Ref<ThreadPoolFuture> future = Ref<ThreadPoolFuture>(memnew(ThreadPoolFuture));
+	job->set_future(future);
+
+	add_job(job);
+
+	return future;
+}
+
+void ThreadPool::add_job_delayed(const Ref<ThreadPoolJob> &job, const float delay) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	if (delay <= 0) {
+		add_job(job);
+		return;
+	}
+
+	_add_timer(job, delay, 0);
+}
+
+void ThreadPool::add_job_repeating(const Ref<ThreadPoolJob> &job, const float interval) {
+	ERR_FAIL_COND(!job.is_valid());
+	ERR_FAIL_COND(interval <= 0);
+
+	_add_timer(job, interval, interval);
+}
+
+void ThreadPool::cancel_job(Ref<ThreadPoolJob> job) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	job->set_cancelled(true);
+
+	_lock_pool();
+
+	_cancel_job_no_lock(job);
+
+	_unlock_pool();
+}
+
+void ThreadPool::cancel_job_wait(Ref<ThreadPoolJob> job) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	job->set_cancelled(true);
+
+	_lock_pool();
+
+	bool running = _cancel_job_no_lock(job);
+
+	_unlock_pool();
+
+	//wait until it's done, on a worker, or in a micro batch
+	while (running) {
+		OS::get_singleton()->delay_usec(100);
+
+		_lock_pool();
+
+		running = _is_job_running_no_lock(job) || job->get_in_mailbox();
+
+		_unlock_pool();
+	}
+}
+
+void ThreadPool::wait_task(const ThreadPoolTaskFuture &future) {
+	while (!future.is_done()) {
+		//Help out instead of just blocking, this way it can't deadlock when called from a worker
+		_lock_pool();
+
+		ThreadPoolTask *task = _pop_task_no_lock();
+
+		_unlock_pool();
+
+		if (task) {
+			_run_task(task);
+			continue;
+		}
+
+		OS::get_singleton()->delay_usec(10);
+	}
+}
+
+bool ThreadPool::help_run_job() {
+	if (!_use_threads) {
+		//Jobs can take more than one frame then, only update() knows how to run them
+		if (!_is_main_thread()) {
+			return false;
+		}
+
+		//Called by a job that update() runs, calling it again would recurse until the stack runs out
+		if (_updating) {
+			return false;
+		}
+
+		update();
+		return true;
+	}
+
+	_lock_pool();
+
+	ThreadPoolTask *task = _pop_task_no_lock();
+	ThreadPoolJob *job = task ? NULL : _take_job_no_lock(_current_worker_index);
+
+	//Recorded, so has_job, cancel_job_wait and the timers see it running
+	if (job) {
+		_helper_jobs.push_back(job);
+	}
+
+	_unlock_pool();
+
+	if (task) {
+		_run_task(task);
+		return true;
+	}
+
+	if (job) {
+		_run_taken_job(job);
+		return true;
+	}
+
+	job = _steal_spawned_job(_current_scratch);
+
+	if (job) {
+		_run_spawned_job(job);
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::_run_taken_job(ThreadPoolJob *job) {
+	ThreadPoolScratch *scratch = _current_scratch;
+
+	if (scratch) {
+		scratch->begin();
+	}
+
+	if (!job->get_cancelled()) {
+		job->execute();
+	}
+
+	if (scratch) {
+		scratch->end();
+	}
+
+	_lock_pool();
+
+	_helper_jobs.erase(job);
+
+	bool category_limited = _category_job_finished_no_lock(job);
+
+	if (!_requeue_job_no_lock(Ref<ThreadPoolJob>(job))) {
+		_job_finished_no_lock(Ref<ThreadPoolJob>(job));
+	}
+
+	_active_count.decrement();
+
+	if (category_limited) {
+		_dispatch_to_idle_contexts_no_lock();
+	}
+
+	//Same as in _thread_finished
+	_recycle_execute_job_no_lock(job);
+	bool free_job = job->unreference();
+
+	_unlock_pool();
+
+	if (free_job) {
+		memdelete(job);
+	}
+}
+
+ThreadPoolArena *ThreadPool::get_current_arena() {
+	if (!_current_scratch) {
+		return NULL;
+	}
+
+	return &_current_scratch->arena;
+}
+
+#if VERSION_MAJOR < 4
+PoolByteArray ThreadPool::take_scratch_bytes(const int size) {
+	PoolByteArray array;
+#else
+PackedByteArray ThreadPool::take_scratch_bytes(const int size) {
+	PackedByteArray array;
+#endif
+
+	if (_current_scratch) {
+		//Moved out, so the caller is the only owner, and writing it doesn't copy
+		SWAP(array, _current_scratch->bytes);
+	}
+
+	array.resize(size);
+
+	return array;
+}
+
+#if VERSION_MAJOR < 4
+void ThreadPool::return_scratch_bytes(const PoolByteArray &array) {
+#else
+void ThreadPool::return_scratch_bytes(const PackedByteArray &array) {
+#endif
+	if (_current_scratch) {
+		_current_scratch->bytes = array;
+	}
+}
+
+#if VERSION_MAJOR < 4
+PoolRealArray ThreadPool::take_scratch_floats(const int size) {
+	PoolRealArray array;
+#else
+PackedFloat32Array ThreadPool::take_scratch_floats(const int size) {
+	PackedFloat32Array array;
+#endif
+
+	if (_current_scratch) {
+		SWAP(array, _current_scratch->floats);
+	}
+
+	array.resize(size);
+
+	return array;
+}
+
+#if VERSION_MAJOR < 4
+void ThreadPool::return_scratch_floats(const PoolRealArray &array) {
+#else
+void ThreadPool::return_scratch_floats(const PackedFloat32Array &array) {
+#endif
+	if (_current_scratch) {
+		_current_scratch->floats = array;
+	}
+}
+
+void ThreadPool::spawn_job(ThreadPoolJob *parent, const Ref<ThreadPoolJob> &child) {
+	ERR_FAIL_COND(!parent);
+	ERR_FAIL_COND(!child.is_valid());
+	ERR_FAIL_COND_MSG(child->is_queued(), "ThreadPool: The job is already queued!");
+	ERR_FAIL_COND_MSG(child->get_spawn_parent(), "ThreadPool: The job is already spawned!");
+
+	child->set_spawn_parent(parent);
+	parent->_child_spawned();
+
+	ThreadPoolScratch *scratch = _current_scratch;
+
+	if (!scratch) {
+		//Not a worker, nothing could steal it
+		child->reference();
+		_run_spawned_job(child.ptr());
+		return;
+	}
+
+	scratch->spawn_lock.lock();
+	scratch->spawned_jobs.push_back(child.ptr());
+	scratch->spawn_lock.unlock();
+
+	//Let idle workers steal it
+	if (_use_threads && _active_count.get() < static_cast<uint32_t>(_context_count)) {
+		_lock_pool();
+
+		_dispatch_to_idle_contexts_no_lock();
+
+		_unlock_pool();
+	}
+}
+
+void ThreadPool::sync_jobs(ThreadPoolJob *parent) {
+	ERR_FAIL_COND(!parent);
+
+	ThreadPoolScratch *scratch = _current_scratch;
+
+	while (parent->get_pending_children_count() > 0) {
+		ThreadPoolJob *job = NULL;
+
+		if (scratch) {
+			//Newest first, it's the most likely to be in the cache
+			scratch->spawn_lock.lock();
+			job = scratch->spawned_jobs.take(scratch->spawned_jobs.back());
+			scratch->spawn_lock.unlock();
+		}
+
+		if (!job) {
+			//The children got stolen, help out the thieves instead of blocking
+			job = _steal_spawned_job(scratch);
+		}
+
+		if (job) {
+			_run_spawned_job(job);
+			continue;
+		}
+
+		OS::get_singleton()->delay_usec(10);
+	}
+}
+
+ThreadPoolJob *ThreadPool::_steal_spawned_job(const ThreadPoolScratch *except, const bool check_categories) {
+	//Contexts don't change while jobs are running, apply_settings waits for them
+	for (int i = -1; i < _context_count; ++i) {
+		ThreadPoolScratch *scratch = i < 0 ? &_main_scratch : &_contexts[i].scratch;
+
+		if (scratch == except) {
+			continue;
+		}
+
+		//Oldest first, it's likely the biggest piece of work
+		scratch->spawn_lock.lock();
+
+		ThreadPoolJob *job = scratch->spawned_jobs.front();
+
+		if (check_categories && _limited_category_count > 0) {
+			//Same as in _take_job_no_lock, children of saturated categories are left for their parent's sync()
+			while (job && !_is_category_available_no_lock(job)) {
+				job = job->get_queue_next();
+			}
+		}
+
+		if (job) {
+			job = scratch->spawned_jobs.take(job);
+		}
+
+		scratch->spawn_lock.unlock();
+
+		if (job) {
+			return job;
+		}
+	}
+
+	return NULL;
+}
+
+void ThreadPool::_run_spawned_job(ThreadPoolJob *job) {
+	ThreadPoolScratch *scratch = _current_scratch;
+
+	if (scratch) {
+		scratch->begin();
+	}
+
+	if (!job->get_cancelled()) {
+		job->execute();
+	}
+
+	if (scratch) {
+		scratch->end();
+	}
+
+	ThreadPoolJob *parent = job->get_spawn_parent();
+	job->set_spawn_parent(NULL);
+
+	if (job->get_group().is_valid() || job->get_future().is_valid()) {
+		_lock_pool();
+
+		_job_finished_no_lock(Ref<ThreadPoolJob>(job));
+
+		_unlock_pool();
+	}
+
+	//Last, the parent can return from sync right after this
+	parent->_child_finished();
+
+	if (job->unreference()) {
+		memdelete(job);
+	}
+}
+
+int ThreadPool::get_current_worker_index() const {
+	return _current_worker_index;
+}
+
+Variant ThreadPool::get_worker_data(const StringName &name, const Variant &default_value) const {
+	ERR_FAIL_COND_V_MSG(!_current_scratch, default_value, "ThreadPool: Worker data is only available on worker threads, and the main thread!");
+
+	const Variant *value = _current_scratch->worker_data.getptr(name);
+
+	if (!value) {
+		return default_value;
+	}
+
+	return *value;
+}
+
+void ThreadPool::set_worker_data(const StringName &name, const Variant &value) {
+	ERR_FAIL_COND_MSG(!_current_scratch, "ThreadPool: Worker data is only available on worker threads, and the main thread!");
+
+	if (value.get_type() == Variant::NIL) {
+		_current_scratch->worker_data.erase(name);
+		return;
+	}
+
+	_current_scratch->worker_data[name] = value;
+}
+
+bool ThreadPool::has_worker_data(const StringName &name) const {
+	if (!_current_scratch) {
+		return false;
+	}
+
+	return _current_scratch->worker_data.has(name);
+}
+
+int ThreadPool::get_worker_arena_size() const {
+	return _worker_arena_size;
+}
+void ThreadPool::set_worker_arena_size(const int value) {
+	ERR_FAIL_COND(value <= 0);
+
+	_worker_arena_size = value;
+	_dirty = true;
+}
+
+ThreadPool::WorkerPriority ThreadPool::get_worker_priority() const {
+	return _worker_priority;
+}
+void ThreadPool::set_worker_priority(const WorkerPriority value) {
+	_worker_priority = value;
+	_dirty = true;
+}
+
+ThreadPool::WorkerPriority ThreadPool::get_worker_thread_priority(const int worker_index) const {
+	if (worker_index < 0 || worker_index >= _worker_priority_overrides.size() || _worker_priority_overrides[worker_index] < 0) {
+		return _worker_priority;
+	}
+
+	return static_cast<WorkerPriority>(_worker_priority_overrides[worker_index]);
+}
+void ThreadPool::set_worker_thread_priority(const int worker_index, const WorkerPriority value) {
+	ERR_FAIL_COND(worker_index < 0);
+
+	while (_worker_priority_overrides.size() <= worker_index) {
+		_worker_priority_overrides.push_back(-1);
+	}
+
+	_worker_priority_overrides.write[worker_index] = value;
+	_dirty = true;
+}
+void ThreadPool::clear_worker_thread_priorities() {
+	_worker_priority_overrides.clear();
+	_dirty = true;
+}
+
+bool ThreadPool::get_sync_stats_enabled() const {
+	return _sync_stats_enabled.is_set();
+}
+void ThreadPool::set_sync_stats_enabled(const bool value) {
+	_sync_stats_enabled.set_to(value);
+}
+
+Dictionary ThreadPool::get_sync_stats() const {
+	Dictionary stats;
+
+	stats["lock_count"] = _sync_lock_count.get();
+	stats["lock_contention_count"] = _sync_lock_contention_count.get();
+	stats["lock_wait_usec"] = _sync_lock_wait_usec.get();
+	stats["lock_wait_max_usec"] = _sync_lock_wait_max_usec.get();
+
+	Array workers;
+
+	//apply_settings can free the contexts, unless the lock is held
+	_lock_pool();
+
+	for (int i = 0; i < _context_count; ++i) {
+		const ThreadPoolContext *context = &_contexts[i];
+
+		Dictionary worker;
+
+		worker["wake_count"] = context->wake_count.get();
+		worker["wake_latency_usec"] = context->wake_latency_usec.get();
+		worker["wake_latency_max_usec"] = context->wake_latency_max_usec.get();
+		worker["assign_count"] = context->assign_count.get();
+		worker["assign_latency_usec"] = context->assign_latency_usec.get();
+		worker["assign_latency_max_usec"] = context->assign_latency_max_usec.get();
+
+		workers.push_back(worker);
+	}
+
+	_unlock_pool();
+
+	stats["workers"] = workers;
+
+	return stats;
+}
+
+void ThreadPool::reset_sync_stats() {
+	_sync_lock_count.set(0);
+	_sync_lock_contention_count.set(0);
+	_sync_lock_wait_usec.set(0);
+	_sync_lock_wait_max_usec.set(0);
+
+	_lock_pool();
+
+	for (int i = 0; i < _context_count; ++i) {
+		ThreadPoolContext *context = &_contexts[i];
+
+		context->wake_count.set(0);
+		context->wake_latency_usec.set(0);
+		context->wake_latency_max_usec.set(0);
+		context->assign_count.set(0);
+		context->assign_latency_usec.set(0);
+		context->assign_latency_max_usec.set(0);
+	}
+
+	_unlock_pool();
+}
+
+void ThreadPool::print_sync_stats() const {
+	if (!_sync_stats_enabled.is_set()) {
+		print_line("ThreadPool: Sync stats are not enabled! Set sync_stats_enabled to true!");
+		return;
+	}
+
+	uint64_t lock_count = _sync_lock_count.get();
+	uint64_t contention_count = _sync_lock_contention_count.get();
+
+	print_line("ThreadPool sync stats:");
+	print_line("  lock: " + itos(lock_count) + " acquisitions, " + itos(contention_count) + " contended, waited " + itos(_sync_lock_wait_usec.get()) + " usec (max " + itos(_sync_lock_wait_max_usec.get()) + " usec)");
+
+	_lock_pool();
+
+	for (int i = 0; i < _context_count; ++i) {
+		const ThreadPoolContext *context = &_contexts[i];
+
+		uint64_t wake_count = context->wake_count.get();
+		uint64_t assign_count = context->assign_count.get();
+
+		uint64_t wake_avg = wake_count > 0 ? context->wake_latency_usec.get() / wake_count : 0;
+		uint64_t assign_avg = assign_count > 0 ? context->assign_latency_usec.get() / assign_count : 0;
+
+		print_line("  worker " + itos(i) + ": wake " + itos(wake_avg) + " usec avg (max " + itos(context->wake_latency_max_usec.get()) + "), assigned to running " + itos(assign_avg) + " usec avg (max " + itos(context->assign_latency_max_usec.get()) + "), " + itos(assign_count) + " runs");
+	}
+
+	_unlock_pool();
+}
+
+ThreadPool::FloatArray ThreadPool::parallel_sort_floats(const FloatArray &array) {
+	FloatArray ret = array;
+
+#if VERSION_MAJOR < 4
+	PoolRealArray::Write w = ret.write();
+	FloatArrayItem *data = w.ptr();
+#else
+	FloatArrayItem *data = ret.ptrw();
+#endif
+
+	ThreadPoolParallel::sort(data, ret.size());
+
+	return ret;
+}
+
+ThreadPool::IntArray ThreadPool::parallel_sort_ints(const IntArray &array) {
+	IntArray ret = array;
+
+#if VERSION_MAJOR < 4
+	PoolIntArray::Write w = ret.write();
+	int *data = w.ptr();
+#else
+	int32_t *data = ret.ptrw();
+#endif
+
+	ThreadPoolParallel::sort(data, ret.size());
+
+	return ret;
+}
+
+real_t ThreadPool::parallel_sum_floats(const FloatArray &array) {
+#if VERSION_MAJOR < 4
+	PoolRealArray::Read r = array.read();
+	const FloatArrayItem *data = r.ptr();
+#else
+	const FloatArrayItem *data = array.ptr();
+#endif
+
+	return ThreadPoolParallel::reduce(data, array.size(), static_cast<FloatArrayItem>(0), [](const FloatArrayItem a, const FloatArrayItem b) { return a + b; });
+}
+
+real_t ThreadPool::parallel_min_floats(const FloatArray &array) {
+	ERR_FAIL_COND_V(array.size() == 0, 0);
+
+#if VERSION_MAJOR < 4
+	PoolRealArray::Read r = array.read();
+	const FloatArrayItem *data = r.ptr();
+#else
+	const FloatArrayItem *data = array.ptr();
+#endif
+
+	return ThreadPoolParallel::reduce(data, array.size(), data[0], [](const FloatArrayItem a, const FloatArrayItem b) { return MIN(a, b); });
+}
+
+real_t ThreadPool::parallel_max_floats(const FloatArray &array) {
+	ERR_FAIL_COND_V(array.size() == 0, 0);
+
+#if VERSION_MAJOR < 4
+	PoolRealArray::Read r = array.read();
+	const FloatArrayItem *data = r.ptr();
+#else
+	const FloatArrayItem *data = array.ptr();
+#endif
+
+	return ThreadPoolParallel::reduce(data, array.size(), data[0], [](const FloatArrayItem a, const FloatArrayItem b) { return MAX(a, b); });
+}
+
+ThreadPool::FloatArray ThreadPool::parallel_prefix_sum_floats(const FloatArray &array) {
+	FloatArray ret = array;
+
+#if VERSION_MAJOR < 4
+	PoolRealArray::Write w = ret.write();
+	FloatArrayItem *data = w.ptr();
+#else
+	FloatArrayItem *data = ret.ptrw();
+#endif
+
+	//Done in place, a write lock doesn't prevent returning a copy
+	ThreadPoolParallel::inclusive_scan(data, data, ret.size(), static_cast<FloatArrayItem>(0), [](const FloatArrayItem a, const FloatArrayItem b) { return a + b; });
+
+	return ret;
+}
+
+Ref<ThreadPoolExecuteJob> ThreadPool::acquire_execute_job() {
+	_lock_pool();
+
+	while (_execute_job_pool.size() > 0) {
+		Ref<ThreadPoolExecuteJob> job = _execute_job_pool[_execute_job_pool.size() - 1];
+		_execute_job_pool.resize(_execute_job_pool.size() - 1);
+
+		//Someone still holds onto it, so it can't be reused
+		if (job->get_reference_count() > 1) {
+			continue;
+		}
+
+		_unlock_pool();
+
+		job->reset();
+
+		return job;
+	}
+
+	_unlock_pool();
+
+	Ref<ThreadPoolExecuteJob> job = Ref<ThreadPoolExecuteJob>(memnew(ThreadPoolExecuteJob));
+	job->set_pooled(true);
+
+	return job;
+}
+
+int ThreadPool::get_execute_job_pool_size() const {
+	return _execute_job_pool_size;
+}
+void ThreadPool::set_execute_job_pool_size(const int value) {
+	_lock_pool();
+
+	_execute_job_pool_size = value;
+
+	if (_execute_job_pool.size() > _execute_job_pool_size) {
+		_execute_job_pool.resize(MAX(_execute_job_pool_size, 0));
+	}
+
+	_unlock_pool();
+}
+
+void ThreadPool::_thread_finished(ThreadPoolContext *context, ThreadPoolJob *job, ThreadPoolTask *task, const bool from_mailbox) {
+	_lock_pool();
+
+	if (task) {
+		context->task.store(NULL);
+		_release_task_no_lock(task);
+	}
+
+	bool category_limited = false;
+
+	if (job) {
+		//A job might have been assigned while a mailbox job ran, that one is left alone
+		if (from_mailbox) {
+			context->mailbox_job.store(NULL);
+		} else {
+			context->job.store(NULL);
+		}
+
+		category_limited = _category_job_finished_no_lock(job);
+
+		if (!_requeue_job_no_lock(Ref<ThreadPoolJob>(job))) {
+			_job_finished_no_lock(Ref<ThreadPoolJob>(job));
+		}
+
+		_active_count.decrement();
+
+		//Stolen child of a spawning job
+		ThreadPoolJob *parent = job->get_spawn_parent();
+
+		if (parent) {
+			job->set_spawn_parent(NULL);
+			parent->_child_finished();
+		}
+	}
+
+	//Something might have been assigned since the worker woke up, that will get it's own post
+	if (context->is_idle()) {
+		_dispatch_no_lock(context);
+	}
+
+	//Queued jobs might have been waiting for this category
+	if (category_limited) {
+		_dispatch_to_idle_contexts_no_lock();
+	}
+
+	bool free_job = false;
+
+	if (job) {
+		_recycle_execute_job_no_lock(job);
+		free_job = job->unreference();
+	}
+
+	_unlock_pool();
+
+	//Deleted outside of the lock, as the destructor might do anything
+	if (free_job) {
+		memdelete(job);
+	}
+}
+
+void ThreadPool::_worker_thread_func(void *user_data) {
+	ThreadPoolContext *context = reinterpret_cast<ThreadPoolContext *>(user_data);
+	ThreadPool *pool = ThreadPool::get_singleton();
+
+	_current_scratch = &context->scratch;
+	_current_worker_index = context->index;
+
+	_apply_thread_priority(context->priority);
+
+	while (true) {
+		context->semaphore->wait();
+
+		if (!context->running.is_set()) {
+			return;
+		}
+
+		if (pool->_sync_stats_enabled.is_set()) {
+			pool->_context_woken(context);
+		}
+
+		pool->_run_context(context);
+	}
+}
+
+void ThreadPool::_engine_task_func(void *user_data) {
+	ThreadPoolContext *context = reinterpret_cast<ThreadPoolContext *>(user_data);
+	ThreadPool *pool = ThreadPool::get_singleton();
+
+	//Engine threads are shared, so the previous values are restored
+	ThreadPoolScratch *scratch = _current_scratch;
+	int worker_index = _current_worker_index;
+
+	_current_scratch = &context->scratch;
+	_current_worker_index = context->index;
+
+	//Same as the worker thread's loop, every wake up is one run
+	do {
+		if (context->running.is_set()) {
+			if (pool->_sync_stats_enabled.is_set()) {
+				pool->_context_woken(context);
+			}
+
+			pool->_run_context(context);
+		}
+	} while (context->engine_wakeups.decrement() > 0);
+
+	_current_scratch = scratch;
+	_current_worker_index = worker_index;
+}
+
+void ThreadPool::_apply_thread_priority(const int priority) {
+#ifdef __linux__
+	//Applies to the calling thread only, Linux threads have their own nice value and policy
+	pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+	if (priority == WORKER_PRIORITY_BACKGROUND) {
+		//Only runs when a core would otherwise be idle
+		struct sched_param param;
+		param.sched_priority = 0;
+
+		if (sched_setscheduler(tid, SCHED_IDLE, &param) != 0) {
+			print_error("ThreadPool: Couldn't set SCHED_IDLE for a worker thread!");
+		}
+
+		return;
+	}
+
+	int nice_value = 0;
+
+	if (priority == WORKER_PRIORITY_LOW) {
+		nice_value = 10;
+	} else if (priority == WORKER_PRIORITY_HIGH) {
+		nice_value = -5;
+	}
+
+	if (nice_value == 0) {
+		return;
+	}
+
+	//Raising the priority needs CAP_SYS_NICE (or a suitable RLIMIT_NICE), the worker just stays at normal otherwise
+	if (setpriority(PRIO_PROCESS, tid, nice_value) != 0) {
+		print_error("ThreadPool: Couldn't change the priority of a worker thread!");
+	}
+#endif
+}
+
+void ThreadPool::_run_context(ThreadPoolContext *context) {
+	ThreadPoolJob *job = context->job.load();
+	ThreadPoolTask *task = context->task.load();
+	bool from_mailbox = false;
+
+	if (!job && !task) {
+		job = _start_mailbox_job(context);
+		from_mailbox = job != NULL;
+	}
+
+	if (_sync_stats_enabled.is_set() && (job || task) && context->assigned_usec.get() != 0) {
+		//Time spent assigned, but not running yet
+		uint64_t latency = OS::get_singleton()->get_ticks_usec() - context->assigned_usec.get();
+		context->assigned_usec.set(0);
+
+		context->assign_count.increment();
+		context->assign_latency_usec.add(latency);
+		context->assign_latency_max_usec.exchange_if_greater(latency);
+	}
+
+	context->scratch.begin();
+
+	if (task) {
+		task->run();
+	} else if (job && !job->get_cancelled()) {
+		job->execute();
+	}
+
+	context->scratch.end();
+
+	_thread_finished(context, job, task, from_mailbox);
+}
+
+ThreadPoolJob *ThreadPool::_start_mailbox_job(ThreadPoolContext *context) {
+	//Only the context's own worker pops its mailbox, so it stays single consumer, and popping doesn't need the lock
+	ThreadPoolJob *job = context->mailbox.pop();
+
+	if (!job) {
+		return NULL;
+	}
+
+	if (job->get_category() == StringName()) {
+		//Active first, so is_working() doesn't see a gap. A cancelled job is still run, _run_context skips it, and finishes it
+		_active_count.increment();
+		_pending_count.decrement();
+
+		//Stored before the mark is cleared, so has_job always finds the job in one of them
+		context->mailbox_job.store(job);
+		job->set_in_mailbox(false);
+
+		return job;
+	}
+
+	//Category counters are only changed under the lock
+	_lock_pool();
+
+	_pending_count.decrement();
+	job->set_in_mailbox(false);
+
+	if (_is_category_available_no_lock(job)) {
+		_category_job_started_no_lock(job);
+		_active_count.increment();
+		context->mailbox_job.store(job);
+
+		_unlock_pool();
+
+		return job;
+	}
+
+	//Moved to the shared queue, which takes it's own reference. It skipped coalescing and the capacity check in add_job_to_worker.
+	//Workers never block on a full queue, so with QUEUE_FULL_POLICY_BLOCK the job fails instead
+	_add_prepared_job_no_lock(Ref<ThreadPoolJob>(job), _queue_full_policy);
+
+	job->unreference();
+
+	_unlock_pool();
+
+	return NULL;
+}
+
+void ThreadPool::_process_timers() {
+	List<ThreadPoolTimerWheel::Timer> expired;
+
+	_lock_pool();
+
+	_timer_wheel.advance(_get_timer_tick(), &expired);
+
+	//The check and the add happen under the same lock, so a run can't slip in between them
+	for (List<ThreadPoolTimerWheel::Timer>::Element *E = expired.front(); E; E = E->next()) {
+		const ThreadPoolTimerWheel::Timer &timer = E->get();
+
+		//Don't pile up runs of a repeating job, if the previous one is still queued or running
+		if (timer.interval > 0 && _has_job_no_lock(timer.job)) {
+			continue;
+		}
+
+		QueueFullPolicy policy = _queue_full_policy;
+
+		//The timer thread can't wait for room in the queue, every timer and micro batch flush would stop with it.
+		//A repeating job skips this run instead, a delayed one fails as with QUEUE_FULL_POLICY_FAIL.
+		if (policy == QUEUE_FULL_POLICY_BLOCK) {
+			if (timer.interval > 0 && _queue_capacity > 0 && _get_queued_job_count_no_lock() >= _queue_capacity) {
+				continue;
+			}
+
+			policy = QUEUE_FULL_POLICY_FAIL;
+		}
+
+		if (timer.job->get_requeued()) {
+			//Requeued jobs were added once already, they keep their deadline
+			timer.job->set_requeued(false);
+			_add_prepared_job_no_lock(timer.job, policy);
+		} else {
+			_add_job_no_lock(timer.job, policy);
+		}
+	}
+
+	_unlock_pool();
+}
+
+void ThreadPool::_flush_expired_micro_batch() {
+	_lock_pool();
+
+	if (_micro_batch && OS::get_singleton()->get_ticks_usec() - _micro_batch_start_usec >= static_cast<uint64_t>(_micro_batch_window * 1000000.0)) {
+		_flush_micro_batch_no_lock();
+	}
+
+	_unlock_pool();
+}
+
+void ThreadPool::_timer_thread_loop() {
+	while (_timer_running.is_set()) {
+		_lock_pool();
+
+		bool idle = _timer_wheel.empty() && !_micro_batch;
+
+		//In OS::get_ticks_usec() time, the earlier of the next timer expiry and the end of the micro batch window
+		uint64_t wake_usec = 0;
+
+		if (!_timer_wheel.empty()) {
+			wake_usec = _timer_start_usec + _timer_wheel.get_next_expiry() * _timer_resolution_usec;
+		}
+
+		if (_micro_batch) {
+			uint64_t flush_usec = _micro_batch_start_usec + static_cast<uint64_t>(_micro_batch_window * 1000000.0);
+
+			if (wake_usec == 0 || flush_usec < wake_usec) {
+				wake_usec = flush_usec;
+			}
+		}
+
+		_unlock_pool();
+
+		{
+			//New timers and micro batches wake the thread, so it can recalculate how long to sleep
+			std::unique_lock<std::mutex> wait_lock(_timer_wait_mutex);
+
+			if (idle) {
+				_timer_wait_condition.wait(wait_lock, [this] { return _timer_wakeup; });
+			} else {
+				uint64_t now = OS::get_singleton()->get_ticks_usec();
+
+				if (wake_usec > now) {
+					_timer_wait_condition.wait_for(wait_lock, std::chrono::microseconds(wake_usec - now), [this] { return _timer_wakeup; });
+				}
+			}
+
+			_timer_wakeup = false;
+		}
+
+		_process_timers();
+		_flush_expired_micro_batch();
+	}
+}
+
+void ThreadPool::_timer_thread_func(void *user_data) {
+	ThreadPool *pool = reinterpret_cast<ThreadPool *>(user_data);
+
+	pool->_timer_thread_loop();
+}
+
+void ThreadPool::register_update() {
+	if (!SceneTree::get_singleton()) {
+		return;
+	}
+
+	if (!SceneTree::get_singleton()->is_connected("idle_frame", this, "update")) {
+		SceneTree::get_singleton()->CONNECT("idle_frame", this, ThreadPool, update);
+	}
+}
+
+void ThreadPool::unregister_update() {
+	if (!SceneTree::get_singleton()) {
+		return;
+	}
+
+	if (SceneTree::get_singleton()->is_connected("idle_frame", this, "update")) {
+		SceneTree::get_singleton()->DISCONNECT("idle_frame", this, ThreadPool, update);
+	}
+}
+
+void ThreadPool::update() {
+	if (_dirty) {
+		apply_settings();
+	}
+
+	_report_missed_deadlines();
+	_resolve_futures();
+
+#if VERSION_MAJOR > 3
+	ThreadPoolResourceLoadJob::collect_abandoned_requests();
+#endif
+
+	if (_use_threads) {
+		if (_use_engine_worker_pool) {
+			_reap_engine_tasks(false);
+		}
+
+		return;
+	}
+
+	_process_timers();
+
+	//Jobs run below can wait on other jobs, help_run_job must not call update() again then
+	_updating = true;
+
+	float remaining_time = _max_time_per_frame;
+
+	if (_task_queue_head) {
+		uint64_t start = OS::get_singleton()->get_ticks_usec();
+
+		//Native tasks can't be split up, so just run the ones that were queued until now
+		ThreadPoolTask *task = _pop_task_no_lock();
+
+		while (task) {
+			_run_task(task);
+			task = _pop_task_no_lock();
+		}
+
+		remaining_time -= (OS::get_singleton()->get_ticks_usec() - start) / 1000000.0;
+	}
+
+	while (remaining_time > 0) {
+		//Jobs with a deadline are run first, as in _take_job_no_lock
+		ThreadPoolJobQueue *queue = &_deadline_queue;
+
+		if (queue->empty()) {
+			queue = &_queue;
+		}
+
+		if (queue->empty()) {
+			break;
+		}
+
+		Ref<ThreadPoolJob> job = Ref<ThreadPoolJob>(queue->front());
+
+		job->set_max_allocated_time(remaining_time);
+
+		_main_scratch.begin();
+		job->execute();
+		_main_scratch.end();
+
+		remaining_time -= job->get_current_execution_time();
+
+		//Unfinished jobs stay in front, and continue while there is time left, unless they asked to be requeued
+		if (!job->get_complete() && !job->get_cancelled() && job->get_requeue_delay() < 0) {
+			continue;
+		}
+
+		_erase_job_no_lock(job);
+
+		if (!_requeue_job_no_lock(job)) {
+			_job_finished_no_lock(job);
+		}
+
+		//job is the last reference of the pool now
+		_recycle_execute_job_no_lock(job.ptr());
+	}
+
+	_updating = false;
+}
+
+void ThreadPool::apply_settings() {
+	if (!_dirty) {
+		return;
+	}
+
+	_lock_pool();
+
+	//Tried again next update, the timer thread keeps running until then
+	if (is_working_no_lock()) {
+		_unlock_pool();
+		return;
+	}
+
+	_dirty = false;
+
+	//New jobs go to the queue until the new contexts are ready
+	_use_threads = false;
+
+	//Blocked producers would wait for the old workers, now they fall back to the non blocking behaviour
+	_wake_all_blocked_producers_no_lock();
+
+	ThreadPoolContext *contexts;
+	void *contexts_memory;
+	int context_count;
+
+	_detach_contexts_no_lock(&contexts, &contexts_memory, &context_count);
+
+	_unlock_pool();
+
+	//Has to happen without holding the lock, as the timer thread also takes it
+	_stop_timer_thread();
+
+	//Workers might be waiting for the lock, so they have to be stopped without holding it
+	_free_contexts(contexts, contexts_memory, context_count);
+
+	_lock_pool();
+
+	unregister_update();
+
+	_use_threads = _use_threads_new;
+	_use_engine_worker_pool = _use_engine_worker_pool_new;
+
+	if (_use_threads) {
+		_create_contexts(_thread_count);
+
+		for (int i = 0; i < _context_count; ++i) {
+			_dispatch_no_lock(&_contexts[i]);
+		}
+
+		_start_timer_thread();
+	}
+
+	//update also reports missed deadlines, so it's needed even when threads are used
+	call_deferred("register_update");
+
+	_unlock_pool();
+}
+
+void ThreadPool::_prepare_job(const Ref<ThreadPoolJob> &job) {
+	if (job->get_deadline() > 0) {
+		job->set_deadline_usec(OS::get_singleton()->get_ticks_usec() + static_cast<uint64_t>(job->get_deadline() * 1000000.0));
+	} else {
+		job->set_deadline_usec(0);
+	}
+}
+
+bool ThreadPool::_assign_to_idle_context_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (!_use_threads || !_is_category_available_no_lock(job.ptr())) {
+		return false;
+	}
+
+	//The preferred worker is tried first, then the rest
+	int start = _get_affinity_worker_no_lock(job.ptr());
+
+	if (start < 0) {
+		start = 0;
+	}
+
+	for (int i = 0; i < _context_count; ++i) {
+		ThreadPoolContext *context = &_contexts[(start + i) % _context_count];
+
+		if (context->is_idle()) {
+			job->reference();
+			_category_job_started_no_lock(job.ptr());
+			_active_count.increment();
+			context->job.store(job.ptr());
+			_wake_context(context);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ThreadPool::_dispatch_no_lock(ThreadPoolContext *context) {
+	//The context is being freed
+	if (!context->running.is_set()) {
+		return false;
+	}
+
+	//The mailbox is not looked at here, the worker pops it in _run_context, every mailbox job has its own wake up
+
+	//Deadline jobs come first, then native tasks, as they are expected to be tiny
+	if (_deadline_queue.empty() && _task_queue_head) {
+		context->task.store(_pop_task_no_lock());
+		_wake_context(context);
+		return true;
+	}
+
+	ThreadPoolJob *job = _take_job_no_lock(context->index);
+
+	if (!job) {
+		job = _steal_spawned_job(&context->scratch, true);
+
+		if (job) {
+			//Children are not counted as pending, their parent is active while they exist
+			_category_job_started_no_lock(job);
+			_active_count.increment();
+		}
+	}
+
+	if (!job) {
+		return false;
+	}
+
+	context->job.store(job);
+	_wake_context(context);
+
+	return true;
+}
+
+void ThreadPool::_dispatch_to_idle_contexts_no_lock() {
+	for (int i = 0; i < _context_count; ++i) {
+		ThreadPoolContext *context = &_contexts[i];
+
+		if (context->is_idle()) {
+			_dispatch_no_lock(context);
+		}
+	}
+}
+
+bool ThreadPool::_is_category_available_no_lock(const ThreadPoolJob *job) const {
+	if (_limited_category_count == 0 || job->get_category() == StringName()) {
+		return true;
+	}
+
+	const CategoryState *state = _categories.getptr(job->get_category());
+
+	return !state || state->limit <= 0 || state->running < state->limit;
+}
+
+void ThreadPool::_category_job_started_no_lock(const ThreadPoolJob *job) {
+	if (job->get_category() == StringName()) {
+		return;
+	}
+
+	//Counted even without a limit, so limits can be set while jobs are running
+	++_categories[job->get_category()].running;
+}
+
+bool ThreadPool::_category_job_finished_no_lock(const ThreadPoolJob *job) {
+	if (job->get_category() == StringName()) {
+		return false;
+	}
+
+	CategoryState *state = _categories.getptr(job->get_category());
+
+	if (!state) {
+		return false;
+	}
+
+	--state->running;
+
+	return state->limit > 0;
+}
+
+void ThreadPool::_create_contexts(const int count) {
+	_context_count = count;
+
+	//memalloc doesn't guarantee cache line alignment
+	_contexts_memory = memalloc(sizeof(ThreadPoolContext) * count + CACHE_LINE_SIZE);
+
+	uintptr_t aligned = (reinterpret_cast<uintptr_t>(_contexts_memory) + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+	_contexts = reinterpret_cast<ThreadPoolContext *>(aligned);
+
+	for (int i = 0; i < _context_count; ++i) {
+		ThreadPoolContext *context = memnew_placement(&_contexts[i], ThreadPoolContext);
+
+		context->index = i;
+		context->priority = get_worker_thread_priority(i);
+		context->running.set();
+		context->scratch.arena.set_block_size(_worker_arena_size);
+		context->semaphore = memnew(Semaphore);
+
+		if (_use_engine_worker_pool) {
+			//Started on demand by _wake_context
+			continue;
+		}
+
+		context->thread = memnew(Thread());
+		context->thread->start(ThreadPool::_worker_thread_func, context);
+	}
+}
+
+//Other threads only look at the contexts while holding the lock, so after this they can be freed without it
+void ThreadPool::_detach_contexts_no_lock(ThreadPoolContext **r_contexts, void **r_contexts_memory, int *r_context_count) {
+	*r_contexts = _contexts;
+	*r_contexts_memory = _contexts_memory;
+	*r_context_count = _context_count;
+
+	//Workers that are still finishing up don't take new work
+	for (int i = 0; i < _context_count; ++i) {
+		_contexts[i].running.clear();
+	}
+
+	_contexts_memory = NULL;
+	_contexts = NULL;
+	_context_count = 0;
+}
+
+void ThreadPool::_free_contexts(ThreadPoolContext *contexts, void *contexts_memory, const int context_count) {
+	if (!contexts) {
+		return;
+	}
+
+	for (int i = 0; i < context_count; ++i) {
+		contexts[i].semaphore->post();
+	}
+
+	//Engine tasks skip their remaining wake ups, once running is cleared
+	_reap_engine_tasks(true);
+
+	for (int i = 0; i < context_count; ++i) {
+		ThreadPoolContext *context = &contexts[i];
+
+		if (context->thread) {
+			context->thread->wait_to_finish();
+
+			memdelete(context->thread);
+		}
+
+		memdelete(context->semaphore);
+
+		ThreadPoolJob *job = context->job.load();
+
+		if (job && job->unreference()) {
+			memdelete(job);
+		}
+
+		ThreadPoolTask *task = context->task.load();
+
+		if (task) {
+			task->discard();
+		}
+
+		job = context->mailbox.pop();
+
+		while (job) {
+			job->set_in_mailbox(false);
+
+			if (job->unreference()) {
+				memdelete(job);
+			}
+
+			job = context->mailbox.pop();
+		}
+
+		context->~ThreadPoolContext();
+	}
+
+	memfree(contexts_memory);
+}
+
+void ThreadPool::_wake_context(ThreadPoolContext *context) {
+	if (_sync_stats_enabled.is_set()) {
+		uint64_t now = OS::get_singleton()->get_ticks_usec();
+
+		context->wake_posted_usec.set(now);
+		context->assigned_usec.set(now);
+	}
+
+#if VERSION_MAJOR > 3
+	if (_use_engine_worker_pool) {
+		if (context->engine_wakeups.increment() == 1) {
+			WorkerThreadPool::TaskID id = WorkerThreadPool::get_singleton()->add_native_task(&ThreadPool::_engine_task_func, context, false, "ThreadPool");
+
+			_engine_task_lock.lock();
+			_engine_tasks.push_back(id);
+			_engine_task_lock.unlock();
+		}
+
+		return;
+	}
+#endif
+
+	context->semaphore->post();
+}
+
+void ThreadPool::_context_woken(ThreadPoolContext *context) {
+	uint64_t posted = context->wake_posted_usec.get();
+
+	if (posted == 0) {
+		return;
+	}
+
+	context->wake_posted_usec.set(0);
+
+	uint64_t latency = OS::get_singleton()->get_ticks_usec() - posted;
+
+	context->wake_count.increment();
+	context->wake_latency_usec.add(latency);
+	context->wake_latency_max_usec.exchange_if_greater(latency);
+}
+
+void ThreadPool::_lock_pool() const {
+	if (!_sync_stats_enabled.is_set()) {
+		_thread_safe_.lock();
+		return;
+	}
+
+	_sync_lock_count.increment();
+
+#if VERSION_MAJOR < 4
+	bool locked = _thread_safe_.try_lock() == OK;
+#else
+	bool locked = _thread_safe_.try_lock();
+#endif
+
+	if (locked) {
+		return;
+	}
+
+	uint64_t start = OS::get_singleton()->get_ticks_usec();
+
+	_thread_safe_.lock();
+
+	uint64_t wait = OS::get_singleton()->get_ticks_usec() - start;
+
+	_sync_lock_contention_count.increment();
+	_sync_lock_wait_usec.add(wait);
+	_sync_lock_wait_max_usec.exchange_if_greater(wait);
+}
+
+void ThreadPool::_unlock_pool() const {
+	_thread_safe_.unlock();
+}
+
+void ThreadPool::_reap_engine_tasks(const bool wait) {
+#if VERSION_MAJOR > 3
+	WorkerThreadPool *worker_pool = WorkerThreadPool::get_singleton();
+
+	_engine_task_lock.lock();
+
+	for (int i = 0; i < _engine_tasks.size(); ++i) {
+		WorkerThreadPool::TaskID id = _engine_tasks[i];
+
+		if (!wait && !worker_pool->is_task_completed(id)) {
+			continue;
+		}
+
+		_engine_tasks.remove_at(i);
+		--i;
+
+		//Finishing tasks can add new ones
+		_engine_task_lock.unlock();
+
+		worker_pool->wait_for_task_completion(id);
+
+		_engine_task_lock.lock();
+	}
+
+	_engine_task_lock.unlock();
+#endif
+}
+
+bool ThreadPool::_enqueue_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (!_insert_job_no_lock(job)) {
+		return false;
+	}
+
+	_pending_count.increment();
+
+	if (job->get_coalesce_key() != StringName()) {
+		_coalesce_index[job->get_coalesce_key()] = job.ptr();
+	}
+
+	_update_queue_pressure_no_lock();
+
+	return true;
+}
+
+//Only links the job into the right queue, the counters are up to the caller
+bool ThreadPool::_insert_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (job->get_deadline_usec() == 0) {
+		return _queue.push_back(job.ptr());
+	}
+
+	//Earliest deadline first, new jobs usually have the latest deadline, so search from the back
+	ThreadPoolJob *prev = _deadline_queue.back();
+
+	while (prev && prev->get_deadline_usec() > job->get_deadline_usec()) {
+		prev = prev->get_queue_prev();
+	}
+
+	return _deadline_queue.insert_after(prev, job.ptr());
+}
+
+ThreadPoolJob *ThreadPool::_take_job_no_lock(const int worker_index) {
+	ThreadPoolJob *job = NULL;
+	ThreadPoolJobQueue *queues[] = { &_deadline_queue, &_queue };
+
+	for (int i = 0; i < 2 && !job; ++i) {
+		ThreadPoolJob *j = queues[i]->front();
+
+		if (_limited_category_count > 0) {
+			//Skip jobs whose category is saturated, instead of making a worker wait for them
+			while (j && !_is_category_available_no_lock(j)) {
+				j = j->get_queue_next();
+			}
+		}
+
+		if (j && worker_index >= 0) {
+			//Prefer a job that wants this worker, but only from the front, so the rest aren't delayed much
+			ThreadPoolJob *a = j;
+
+			for (int n = 0; a && n < AFFINITY_SCAN_DEPTH; a = a->get_queue_next(), ++n) {
+				if (_get_affinity_worker_no_lock(a) == worker_index && _is_category_available_no_lock(a)) {
+					j = a;
+					break;
+				}
+			}
+		}
+
+		if (j) {
+			job = queues[i]->take(j);
+		}
+	}
+
+	if (!job) {
+		return NULL;
+	}
+
+	_unindex_coalesce_key_no_lock(job);
+
+	//The caller assigns it to a worker
+	_category_job_started_no_lock(job);
+	_active_count.increment();
+	_pending_count.decrement();
+
+	_update_queue_pressure_no_lock();
+
+	return job;
+}
+
+int ThreadPool::_get_affinity_worker_no_lock(const ThreadPoolJob *job) const {
+	if (_context_count == 0 || job->get_affinity_key() == StringName()) {
+		return -1;
+	}
+
+	return job->get_affinity_key().hash() % _context_count;
+}
+
+bool ThreadPool::_has_job_no_lock(const Ref<ThreadPoolJob> &job) const {
+	if (job->get_in_mailbox() || job->get_requeued() || _is_job_running_no_lock(job) || _queue.has(job.ptr()) || _deadline_queue.has(job.ptr())) {
+		return true;
+	}
+
+	return _micro_batch && _micro_batch->has(job.ptr());
+}
+
+bool ThreadPool::_is_job_running_no_lock(const Ref<ThreadPoolJob> &job) const {
+	for (int i = 0; i < _context_count; ++i) {
+		if (_contexts[i].job.load() == job.ptr() || _contexts[i].mailbox_job.load() == job.ptr()) {
+			return true;
+		}
+	}
+
+	if (_helper_jobs.find(job.ptr()) != -1) {
+		return true;
+	}
+
+	//Flushed micro batches finish their own jobs, cancelled ones are just skipped
+	if (job->get_micro()) {
+		for (int i = 0; i < _flushed_micro_batches.size(); ++i) {
+			if (_flushed_micro_batches[i]->has(job.ptr())) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+//Returns whether the job is still running, in that case the worker finishes it
+bool ThreadPool::_cancel_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	//A repeating job can be both scheduled and queued, so both have to be removed
+	bool scheduled = _timer_wheel.remove(job);
+	bool queued = _erase_job_no_lock(job);
+
+	job->set_requeued(false);
+
+	//Mailboxes can only be popped by their worker, it skips the cancelled job and finishes it
+	if (_is_job_running_no_lock(job) || job->get_in_mailbox()) {
+		return true;
+	}
+
+	if (scheduled || queued) {
+		_job_finished_no_lock(job);
+	}
+
+	return false;
+}
+
+bool ThreadPool::_erase_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (_deadline_queue.erase(job.ptr()) || _queue.erase(job.ptr())) {
+		_unindex_coalesce_key_no_lock(job.ptr());
+		_pending_count.decrement();
+		_update_queue_pressure_no_lock();
+		return true;
+	}
+
+	//Batches that are not flushed yet can still give their jobs back
+	if (_micro_batch && _micro_batch->erase(job.ptr())) {
+		_pending_count.decrement();
+		return true;
+	}
+
+	return false;
+}
+
+bool ThreadPool::_coalesce_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	ThreadPoolJob **queued = _coalesce_index.getptr(job->get_coalesce_key());
+
+	if (!queued) {
+		return false;
+	}
+
+	if (_coalesce_policy == COALESCE_POLICY_KEEP_OLDEST) {
+		//The queued job will do the work, the new one is finished as cancelled
+		job->set_cancelled(true);
+		_job_finished_no_lock(job);
+		return true;
+	}
+
+	//COALESCE_POLICY_KEEP_NEWEST, the new job replaces the queued one
+	Ref<ThreadPoolJob> old = Ref<ThreadPoolJob>(*queued);
+	ThreadPoolJobQueue *queue = _deadline_queue.has(old.ptr()) ? &_deadline_queue : &_queue;
+
+	ERR_FAIL_COND_V_MSG(!queue->has(old.ptr()), false, "ThreadPool: The coalesce index points at a job that is not queued!");
+
+	//The earlier deadline of the two is kept, the work was already promised by the old one's. 0 means no deadline
+	uint64_t old_deadline = old->get_deadline_usec();
+	uint64_t deadline = job->get_deadline_usec();
+
+	if (deadline == 0 || (old_deadline != 0 && old_deadline < deadline)) {
+		deadline = old_deadline;
+	}
+
+	job->set_deadline_usec(deadline);
+
+	bool inserted;
+
+	if (deadline == old_deadline) {
+		//Takes the queued one's place, so it keeps its turn
+		inserted = queue->insert_after(old.ptr(), job.ptr());
+	} else {
+		//Its own deadline is earlier, so it moves forward in the deadline queue
+		inserted = _insert_job_no_lock(job);
+	}
+
+	if (!inserted) {
+		return false;
+	}
+
+	//One job in, one out, the pending count and the queue size stay the same
+	queue->erase(old.ptr());
+	*queued = job.ptr();
+
+	old->set_cancelled(true);
+	_job_finished_no_lock(old);
+
+	return true;
+}
+
+void ThreadPool::_unindex_coalesce_key_no_lock(const ThreadPoolJob *job) {
+	if (job->get_coalesce_key() == StringName()) {
+		return;
+	}
+
+	ThreadPoolJob **indexed = _coalesce_index.getptr(job->get_coalesce_key());
+
+	//Only one job per key can be queued, and it's always the indexed one
+	ERR_FAIL_COND_MSG(!indexed || *indexed != job, "ThreadPool: The coalesce index is out of sync with the queue!");
+
+	_coalesce_index.erase(job->get_coalesce_key());
 }
-void ThreadPool::set_max_time_per_frame(const float value) {
-	_max_time_per_frame = value;
+
+void ThreadPool::_discard_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	//Groups and futures still get notified, as cancelled
+	_erase_job_no_lock(job);
+
+	job->set_cancelled(true);
+	_job_finished_no_lock(job);
 }
 
-float ThreadPool::get_max_work_per_frame_percent() const {
-	return _max_work_per_frame_percent;
+int ThreadPool::_get_queued_job_count_no_lock() const {
+	return _queue.size() + _deadline_queue.size();
 }
-void ThreadPool::set_max_work_per_frame_percent(const float value) {
-	_max_work_per_frame_percent = value;
 
-	apply_max_work_per_frame_percent();
+void ThreadPool::_update_queue_pressure_no_lock() {
+	//Every change of the queue size (or capacity) goes through here
+	_wake_blocked_producer_no_lock();
+
+	if (_queue_capacity <= 0) {
+		_queue_under_pressure = false;
+		return;
+	}
+
+	int count = _get_queued_job_count_no_lock();
+
+	if (!_queue_under_pressure) {
+		if (count >= _queue_capacity) {
+			_queue_under_pressure = true;
+			call_deferred("emit_signal", "queue_pressure");
+		}
+
+		return;
+	}
+
+	//Only signal again after the queue drained a bit, so it doesn't fire for every job
+	if (count <= _queue_capacity / 2) {
+		_queue_under_pressure = false;
+	}
 }
 
-float ThreadPool::get_target_fps() const {
-	return _target_fps;
+void ThreadPool::_wake_blocked_producer_no_lock() {
+	if (_blocked_producer_count == 0) {
+		return;
+	}
+
+	if (_queue_capacity > 0 && _get_queued_job_count_no_lock() >= _queue_capacity) {
+		return;
+	}
+
+	//One producer per call, the woken one takes itself off the count here, so no posts are left over.
+	//If there is still room after it added its job, that update wakes the next one.
+	--_blocked_producer_count;
+	_blocked_producer_semaphore->post();
 }
-void ThreadPool::set_target_fps(const float value) {
-	_target_fps = value;
 
-	apply_max_work_per_frame_percent();
+void ThreadPool::_wake_all_blocked_producers_no_lock() {
+	//They check again whether blocking is still possible
+	while (_blocked_producer_count > 0) {
+		--_blocked_producer_count;
+		_blocked_producer_semaphore->post();
+	}
 }
 
-void ThreadPool::apply_max_work_per_frame_percent() {
-	_max_time_per_frame = (1.0 / _target_fps) * (_max_work_per_frame_percent / 100.0);
+bool ThreadPool::_can_block_on_full_queue_no_lock() const {
+	//Nothing would drain the queue
+	if (!_use_threads) {
+		return false;
+	}
+
+	//Workers waiting on each other could deadlock. Set for both backends, engine mode contexts don't have a thread
+	return _current_worker_index < 0;
 }
 
-bool ThreadPool::is_working() const {
-	_THREAD_SAFE_LOCK_
+void ThreadPool::_job_finished_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (job->get_deadline_usec() != 0) {
+		if (!job->get_cancelled() && OS::get_singleton()->get_ticks_usec() > job->get_deadline_usec()) {
+			++_missed_deadline_count_current_frame;
+			++_total_missed_deadline_count;
+		}
 
-	if (_queue.size() > 0) {
-		_THREAD_SAFE_UNLOCK_
+		job->set_deadline_usec(0);
+	}
 
-		return true;
+	Ref<ThreadPoolJobGroup> group = job->get_group();
+
+	if (group.is_valid()) {
+		job->set_group(Ref<ThreadPoolJobGroup>());
+		group->_job_finished();
 	}
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		if (_threads[i]->job.is_valid()) {
-			_THREAD_SAFE_UNLOCK_
-			return true;
-		}
+	//Futures are resolved on the main thread, in update()
+	if (job->get_future().is_valid()) {
+		_finished_future_jobs.push_back(job);
+		return;
 	}
+}
 
-	_THREAD_SAFE_UNLOCK_
+//Called right before the pool drops its last reference to a finished job. Pooled execute jobs go to the free list,
+//but only if nobody else holds them. Checked under the lock, as outside of it only the pool hands out these jobs.
+void ThreadPool::_recycle_execute_job_no_lock(ThreadPoolJob *job) {
+	if (_execute_job_pool.size() >= _execute_job_pool_size || job->get_reference_count() != 1) {
+		return;
+	}
 
-	return false;
-}
+	ThreadPoolExecuteJob *execute_job = Object::cast_to<ThreadPoolExecuteJob>(job);
 
-bool ThreadPool::is_working_no_lock() const {
-	if (_queue.size() > 0) {
-		return true;
+	if (execute_job && execute_job->get_pooled()) {
+		_execute_job_pool.push_back(Ref<ThreadPoolExecuteJob>(execute_job));
 	}
+}
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		if (_threads[i]->job.is_valid()) {
-			return true;
+void ThreadPool::_add_micro_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	if (!_micro_batch) {
+		_micro_batch = memnew(ThreadPoolJobQueue);
+		_micro_batch_start_usec = OS::get_singleton()->get_ticks_usec();
+
+		//The timer thread flushes the batch when its window passes
+		if (_timer_thread) {
+			_wake_timer_thread();
 		}
 	}
 
-	return false;
+	_micro_batch->push_back(job.ptr());
+	_pending_count.increment();
+
+	if (_micro_batch->size() >= _micro_batch_size) {
+		_flush_micro_batch_no_lock();
+	}
 }
 
-bool ThreadPool::has_job(const Ref<ThreadPoolJob> &job) {
-	_THREAD_SAFE_LOCK_
+void ThreadPool::_flush_micro_batch_no_lock() {
+	if (!_micro_batch) {
+		return;
+	}
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		ThreadPoolContext *context = _threads.get(i);
+	ThreadPoolJobQueue *batch = _micro_batch;
+	_micro_batch = NULL;
 
-		if (context->job == job) {
-			_THREAD_SAFE_UNLOCK_
-			return true;
-		}
+	if (batch->empty()) {
+		//Every job of it got cancelled
+		memdelete(batch);
+		return;
 	}
 
-	List<Ref<ThreadPoolJob>>::Element *E = _queue.find(job);
+	_flushed_micro_batches.push_back(batch);
+
+	ThreadPoolTask *task = _acquire_task_no_lock();
 
-	_THREAD_SAFE_UNLOCK_
+	task->set([this, batch]() {
+		_run_micro_batch(batch);
+	});
 
-	return E;
+	_submit_task_no_lock(task);
 }
 
-void ThreadPool::add_job(const Ref<ThreadPoolJob> &job) {
-	_THREAD_SAFE_LOCK_
+void ThreadPool::_run_micro_batch(ThreadPoolJobQueue *batch) {
+	ThreadPoolScratch *scratch = _current_scratch;
 
-	if (_use_threads) {
-		for (int i = 0; i < _threads.size(); ++i) {
-			ThreadPoolContext *context = _threads.get(i);
+	for (ThreadPoolJob *job = batch->front(); job; job = job->get_queue_next()) {
+		if (!job->get_cancelled()) {
+			job->execute();
+		}
 
-			if (!context->job.is_valid()) {
-				context->job = job;
-				context->semaphore->post();
-				_THREAD_SAFE_UNLOCK_
-				return;
-			}
+		//Every job gets a clean arena, like when it runs alone. Not when the batch runs nested in another job
+		if (scratch && scratch->depth == 1) {
+			scratch->arena.reset();
 		}
 	}
 
-	_queue.push_back(job);
+	Vector<ThreadPoolJob *> freed;
 
-	_THREAD_SAFE_UNLOCK_
-}
+	//One lock for the whole batch. The jobs are taken out under it, so has_job and add_job see a consistent state
+	_lock_pool();
 
-void ThreadPool::cancel_job(Ref<ThreadPoolJob> job) {
-	ERR_FAIL_COND(!job.is_valid());
+	_flushed_micro_batches.erase(batch);
 
-	job->set_cancelled(true);
+	ThreadPoolJob *job = batch->take_front();
 
-	_THREAD_SAFE_LOCK_
+	while (job) {
+		_job_finished_no_lock(Ref<ThreadPoolJob>(job));
+		_pending_count.decrement();
 
-	_queue.erase(job);
+		_recycle_execute_job_no_lock(job);
 
-	_THREAD_SAFE_UNLOCK_
-}
+		if (job->unreference()) {
+			freed.push_back(job);
+		}
 
-void ThreadPool::cancel_job_wait(Ref<ThreadPoolJob> job) {
-	ERR_FAIL_COND(!job.is_valid());
+		job = batch->take_front();
+	}
 
-	job->set_cancelled(true);
+	_unlock_pool();
 
-	_THREAD_SAFE_LOCK_
+	memdelete(batch);
 
-	if (_queue.erase(job)) {
-		_THREAD_SAFE_UNLOCK_
-		return;
+	for (int i = 0; i < freed.size(); ++i) {
+		memdelete(freed[i]);
 	}
+}
 
-	_THREAD_SAFE_UNLOCK_
+void ThreadPool::_report_missed_deadlines() {
+	_lock_pool();
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		Ref<ThreadPoolJob> j = _threads[i]->job;
+	_missed_deadline_count = _missed_deadline_count_current_frame;
+	_missed_deadline_count_current_frame = 0;
 
-		if (j == job) {
-			//wait until it's done
-			while (_threads[i]->job == job) {
-				OS::get_singleton()->delay_usec(100);
-			}
+	_unlock_pool();
 
-			return;
-		}
+	if (_missed_deadline_count > 0) {
+		emit_signal("deadlines_missed", _missed_deadline_count);
 	}
 }
 
-void ThreadPool::_thread_finished(ThreadPoolContext *context) {
-	_THREAD_SAFE_LOCK_
+ThreadPoolTask *ThreadPool::_acquire_task_no_lock() {
+	if (!_free_tasks) {
+		ThreadPoolTask *chunk = memnew_arr(ThreadPoolTask, TASK_CHUNK_SIZE);
+		_task_chunks.push_back(chunk);
 
-	context->job.unref();
+		for (int i = 0; i < TASK_CHUNK_SIZE; ++i) {
+			chunk[i].next = _free_tasks;
+			_free_tasks = &chunk[i];
+		}
+	}
+
+	ThreadPoolTask *task = _free_tasks;
+	_free_tasks = task->next;
+	task->next = NULL;
+
+	return task;
+}
+
+void ThreadPool::_submit_task_no_lock(ThreadPoolTask *task) {
+	if (_use_threads) {
+		for (int i = 0; i < _context_count; ++i) {
+			ThreadPoolContext *context = &_contexts[i];
 
-	while (_queue.size() > 0 && !context->job.is_valid()) {
-		context->job = _queue.front()->get();
-		_queue.pop_front();
+			if (context->is_idle()) {
+				_active_count.increment();
+				context->task.store(task);
+				_wake_context(context);
+				return;
+			}
+		}
 	}
 
-	if (context->job.is_valid()) {
-		context->semaphore->post();
+	if (_task_queue_tail) {
+		_task_queue_tail->next = task;
+	} else {
+		_task_queue_head = task;
 	}
 
-	_THREAD_SAFE_UNLOCK_
+	_task_queue_tail = task;
+
+	_pending_count.increment();
 }
 
-void ThreadPool::_worker_thread_func(void *user_data) {
-	ThreadPoolContext *context = reinterpret_cast<ThreadPoolContext *>(user_data);
+ThreadPoolTask *ThreadPool::_pop_task_no_lock() {
+	ThreadPoolTask *task = _task_queue_head;
 
-	while (context->running) {
-		context->semaphore->wait();
+	if (!task) {
+		return NULL;
+	}
 
-		if (!context->job.is_valid()) {
-			ThreadPool::get_singleton()->_thread_finished(context);
-			continue;
-		}
+	_task_queue_head = task->next;
 
-		if (context->job->get_cancelled()) {
-			ThreadPool::get_singleton()->_thread_finished(context);
-			continue;
-		}
+	if (!_task_queue_head) {
+		_task_queue_tail = NULL;
+	}
 
-		context->job->execute();
+	//Popped tasks are run right away, until they are released
+	_active_count.increment();
+	_pending_count.decrement();
 
-		ThreadPool::get_singleton()->_thread_finished(context);
-	}
+	task->next = NULL;
+
+	return task;
 }
 
-void ThreadPool::register_update() {
-	if (!SceneTree::get_singleton()) {
-		return;
+void ThreadPool::_release_task_no_lock(ThreadPoolTask *task) {
+	//Has to happen after the callable was destroyed, futures will see the task as done from now on
+	task->generation.increment();
+
+	task->next = _free_tasks;
+	_free_tasks = task;
+
+	_active_count.decrement();
+}
+
+void ThreadPool::_run_task(ThreadPoolTask *task) {
+	ThreadPoolScratch *scratch = _current_scratch;
+
+	if (scratch) {
+		scratch->begin();
 	}
 
-	if (!SceneTree::get_singleton()->is_connected("idle_frame", this, "update")) {
-		SceneTree::get_singleton()->CONNECT("idle_frame", this, ThreadPool, update);
+	task->run();
+
+	if (scratch) {
+		scratch->end();
 	}
+
+	_lock_pool();
+
+	_release_task_no_lock(task);
+
+	_unlock_pool();
 }
 
-void ThreadPool::unregister_update() {
-	if (!SceneTree::get_singleton()) {
+void ThreadPool::_resolve_futures() {
+	List<Ref<ThreadPoolJob>> jobs;
+
+	_lock_pool();
+
+	if (_finished_future_jobs.size() == 0) {
+		_unlock_pool();
 		return;
 	}
 
-	if (SceneTree::get_singleton()->is_connected("idle_frame", this, "update")) {
-		SceneTree::get_singleton()->DISCONNECT("idle_frame", this, ThreadPool, update);
+	SWAP(jobs, _finished_future_jobs);
+
+	_unlock_pool();
+
+	for (List<Ref<ThreadPoolJob>>::Element *E = jobs.front(); E; E = E->next()) {
+		Ref<ThreadPoolJob> job = E->get();
+
+		Ref<ThreadPoolFuture> future = job->get_future();
+		job->set_future(Ref<ThreadPoolFuture>());
+
+		future->resolve(job->get_result(), job->get_cancelled());
 	}
 }
 
-void ThreadPool::update() {
-	if (_dirty) {
-		apply_settings();
-	}
+void ThreadPool::_add_timer(const Ref<ThreadPoolJob> &job, const float delay, const float interval) {
+	uint64_t delay_ticks = _seconds_to_timer_ticks(delay);
+	uint64_t interval_ticks = 0;
 
-	if (_use_threads) {
-		return;
+	if (interval > 0) {
+		interval_ticks = _seconds_to_timer_ticks(interval);
 	}
 
-	if (_queue.size() == 0) {
-		return;
+	_lock_pool();
+
+	_add_timer_no_lock(job, delay_ticks, interval_ticks);
+
+	_unlock_pool();
+}
+
+void ThreadPool::_add_timer_no_lock(const Ref<ThreadPoolJob> &job, const uint64_t delay_ticks, const uint64_t interval_ticks) {
+	_timer_wheel.add(job, _get_timer_tick() + delay_ticks, interval_ticks);
+
+	//The new timer might expire before the one the timer thread sleeps for
+	if (_timer_thread) {
+		_wake_timer_thread();
 	}
+}
 
-	float remaining_time = _max_time_per_frame;
+//Jobs that wait for something outside of the pool return unfinished after calling requeue(),
+//they go back to the queue after the delay, instead of being finished
+bool ThreadPool::_requeue_job_no_lock(const Ref<ThreadPoolJob> &job) {
+	float delay = job->get_requeue_delay();
+	job->clear_requeue();
 
-	while (remaining_time > 0 && _queue.size() > 0) {
-		Ref<ThreadPoolJob> job = _queue.front()->get();
+	//Stolen children are finished by their parent's sync
+	if (delay < 0 || job->get_complete() || job->get_cancelled() || job->get_spawn_parent()) {
+		return false;
+	}
 
-		if (!job.is_valid()) {
-			_queue.pop_front();
-			continue;
-		}
+	job->set_requeued(true);
+	_add_timer_no_lock(job, _seconds_to_timer_ticks(delay), 0);
 
-		job->set_max_allocated_time(remaining_time);
-		job->execute();
+	return true;
+}
 
-		remaining_time -= job->get_current_execution_time();
+uint64_t ThreadPool::_seconds_to_timer_ticks(const float seconds) const {
+	uint64_t usec = static_cast<uint64_t>(seconds * 1000000.0);
+	uint64_t ticks = (usec + _timer_resolution_usec - 1) / _timer_resolution_usec;
 
-		if (job->get_complete() || job->get_cancelled()) {
-			_queue.pop_front();
-		}
+	if (ticks == 0) {
+		ticks = 1;
 	}
+
+	return ticks;
 }
 
-void ThreadPool::apply_settings() {
-	if (!_dirty) {
+uint64_t ThreadPool::_get_timer_tick() const {
+	return (OS::get_singleton()->get_ticks_usec() - _timer_start_usec) / _timer_resolution_usec;
+}
+
+void ThreadPool::_start_timer_thread() {
+	if (_timer_thread) {
 		return;
 	}
 
-	_THREAD_SAFE_LOCK_
+	_timer_running.set();
+	_timer_wakeup = false;
 
-	if (is_working_no_lock()) {
-		_THREAD_SAFE_UNLOCK_
+	_timer_thread = memnew(Thread());
+	_timer_thread->start(ThreadPool::_timer_thread_func, this);
+}
+
+void ThreadPool::_stop_timer_thread() {
+	if (!_timer_thread) {
 		return;
 	}
 
-	_dirty = false;
+	_timer_running.clear();
+	_wake_timer_thread();
+	_timer_thread->wait_to_finish();
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		ThreadPoolContext *context = _threads[i];
+	memdelete(_timer_thread);
 
-		CRASH_COND(context->job.is_valid());
+	_timer_thread = NULL;
+}
 
-		context->running = false;
-		context->semaphore->post();
-		context->thread->wait_to_finish();
-		memdelete(context->thread);
-		memdelete(context->semaphore);
-		memdelete(context);
+void ThreadPool::_wake_timer_thread() {
+	{
+		std::lock_guard<std::mutex> wait_lock(_timer_wait_mutex);
+		_timer_wakeup = true;
 	}
 
-	_threads.resize(0);
+	_timer_wait_condition.notify_one();
+}
 
-	unregister_update();
+ThreadPool::ThreadPool() {
+	_instance = this;
 
-	_use_threads = _use_threads_new;
+	_timer_thread = NULL;
+	_timer_wakeup = false;
 
-	if (_use_threads) {
-		_threads.resize(_thread_count);
+	_blocked_producer_count = 0;
+	_blocked_producer_semaphore = memnew(Semaphore);
 
-		for (int i = 0; i < _threads.size(); ++i) {
-			ThreadPoolContext *context = memnew(ThreadPoolContext);
+	_contexts_memory = NULL;
+	_contexts = NULL;
+	_context_count = 0;
 
-			context->running = true;
-			context->semaphore = memnew(Semaphore);
+	_free_tasks = NULL;
+	_task_queue_head = NULL;
+	_task_queue_tail = NULL;
 
-			context->thread = memnew(Thread());
-			context->thread->start(ThreadPool::_worker_thread_func, context);
+	_missed_deadline_count = 0;
+	_missed_deadline_count_current_frame = 0;
+	_total_missed_deadline_count = 0;
 
-			_threads.write[i] = context;
-		}
-	} else {
-		call_deferred("register_update");
-	}
+	_queue_under_pressure = false;
+	_limited_category_count = 0;
 
-	_THREAD_SAFE_UNLOCK_
-}
+	_micro_batch = NULL;
+	_micro_batch_start_usec = 0;
 
-ThreadPool::ThreadPool() {
-	_instance = this;
+	_sync_stats_enabled.set_to(GLOBAL_DEF("thread_pool/sync_stats_enabled", false));
 
 	_use_threads = GLOBAL_DEF("thread_pool/use_threads", true);
+	_use_engine_worker_pool = GLOBAL_DEF("thread_pool/use_engine_worker_pool", false);
+
+#if VERSION_MAJOR < 4
+	if (_use_engine_worker_pool) {
+		print_error("ThreadPool: use_engine_worker_pool is only available in Godot 4! Check ProjectSettings/ThreadPool/use_engine_worker_pool! Set to false!");
+
+		_use_engine_worker_pool = false;
+	}
+#endif
+
 	_thread_count = GLOBAL_DEF("thread_pool/thread_count", -1);
 	_thread_fallback_count = GLOBAL_DEF("thread_pool/thread_fallback_count", 4);
 
@@ -390,6 +2576,71 @@ ThreadPool::ThreadPool() {
 
 	apply_max_work_per_frame_percent();
 
+	_timer_resolution_usec = GLOBAL_DEF("thread_pool/timer_resolution_usec", 1000);
+
+	if (_timer_resolution_usec <= 0) {
+		print_error("ThreadPool: timer_resolution_usec is invalid! Check ProjectSettings/ThreadPool/timer_resolution_usec! Needs to be > 0! Set to 1000!");
+
+		_timer_resolution_usec = 1000;
+	}
+
+	_timer_start_usec = OS::get_singleton()->get_ticks_usec();
+
+	_execute_job_pool_size = GLOBAL_DEF("thread_pool/execute_job_pool_size", 256);
+
+	_worker_arena_size = GLOBAL_DEF("thread_pool/worker_arena_size", 65536);
+
+	if (_worker_arena_size <= 0) {
+		print_error("ThreadPool: worker_arena_size is invalid! Check ProjectSettings/ThreadPool/worker_arena_size! Needs to be > 0! Set to 65536!");
+
+		_worker_arena_size = 65536;
+	}
+
+	_main_scratch.arena.set_block_size(_worker_arena_size);
+
+	int worker_priority = GLOBAL_DEF("thread_pool/worker_priority", 0);
+
+	if (worker_priority < WORKER_PRIORITY_NORMAL || worker_priority > WORKER_PRIORITY_HIGH) {
+		print_error("ThreadPool: worker_priority is invalid! Check ProjectSettings/ThreadPool/worker_priority! Set to 0 (Normal)!");
+
+		worker_priority = WORKER_PRIORITY_NORMAL;
+	}
+
+	_worker_priority = static_cast<WorkerPriority>(worker_priority);
+	_current_scratch = &_main_scratch;
+
+	_queue_capacity = GLOBAL_DEF("thread_pool/queue_capacity", 0);
+
+	int queue_full_policy = GLOBAL_DEF("thread_pool/queue_full_policy", 0);
+
+	if (queue_full_policy < QUEUE_FULL_POLICY_BLOCK || queue_full_policy > QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY) {
+		print_error("ThreadPool: queue_full_policy is invalid! Check ProjectSettings/ThreadPool/queue_full_policy! Set to 0 (Block)!");
+
+		queue_full_policy = QUEUE_FULL_POLICY_BLOCK;
+	}
+
+	_queue_full_policy = static_cast<QueueFullPolicy>(queue_full_policy);
+
+	int coalesce_policy = GLOBAL_DEF("thread_pool/coalesce_policy", 0);
+
+	if (coalesce_policy < COALESCE_POLICY_KEEP_NEWEST || coalesce_policy > COALESCE_POLICY_KEEP_OLDEST) {
+		print_error("ThreadPool: coalesce_policy is invalid! Check ProjectSettings/ThreadPool/coalesce_policy! Set to 0 (Keep Newest)!");
+
+		coalesce_policy = COALESCE_POLICY_KEEP_NEWEST;
+	}
+
+	_coalesce_policy = static_cast<CoalescePolicy>(coalesce_policy);
+
+	_micro_batch_size = GLOBAL_DEF("thread_pool/micro_batch_size", 32);
+
+	if (_micro_batch_size <= 0) {
+		print_error("ThreadPool: micro_batch_size is invalid! Check ProjectSettings/ThreadPool/micro_batch_size! Needs to be > 0! Set to 32!");
+
+		_micro_batch_size = 32;
+	}
+
+	_micro_batch_window = GLOBAL_DEF("thread_pool/micro_batch_window", 0.001);
+
 	if (!OS::get_singleton()->can_use_threads()) {
 		_use_threads = false;
 	}
@@ -406,34 +2657,64 @@ ThreadPool::ThreadPool() {
 	}
 
 	_use_threads_new = _use_threads;
+	_use_engine_worker_pool_new = _use_engine_worker_pool;
 
 	_dirty = true;
+	_updating = false;
 
 	apply_settings();
 }
 
 ThreadPool::~ThreadPool() {
-	for (int i = 0; i < _threads.size(); ++i) {
-		ThreadPoolContext *context = _threads.get(i);
+	_stop_timer_thread();
+
+	ThreadPoolContext *contexts;
+	void *contexts_memory;
+	int context_count;
+
+	_lock_pool();
+
+	_detach_contexts_no_lock(&contexts, &contexts_memory, &context_count);
 
-		context->running = false;
-		context->semaphore->post();
+	_unlock_pool();
+
+	_free_contexts(contexts, contexts_memory, context_count);
+
+	memdelete(_blocked_producer_semaphore);
+	_blocked_producer_semaphore = NULL;
+
+	if (_micro_batch) {
+		memdelete(_micro_batch);
+		_micro_batch = NULL;
 	}
 
-	for (int i = 0; i < _threads.size(); ++i) {
-		ThreadPoolContext *context = _threads.get(i);
+	_coalesce_index.clear();
+	_queue.clear();
+	_deadline_queue.clear();
+	_timer_wheel.clear();
+	_finished_future_jobs.clear();
+	_execute_job_pool.clear();
+
+	ThreadPoolTask *task = _pop_task_no_lock();
 
-		context->thread->wait_to_finish();
+	while (task) {
+		task->discard();
+		task = _pop_task_no_lock();
+	}
 
-		memdelete(context->thread);
-		memdelete(context->semaphore);
-		context->job.unref();
-		memdelete(context);
+	//Their tasks were discarded above (or in _free_contexts), deleting the batches gives back the references to their jobs
+	for (int i = 0; i < _flushed_micro_batches.size(); ++i) {
+		memdelete(_flushed_micro_batches[i]);
 	}
 
-	_threads.clear();
+	_flushed_micro_batches.clear();
 
-	_queue.clear();
+	for (int i = 0; i < _task_chunks.size(); ++i) {
+		memdelete_arr(_task_chunks[i]);
+	}
+
+	_task_chunks.clear();
+	_free_tasks = NULL;
 }
 
 void ThreadPool::_bind_methods() {
@@ -449,6 +2730,10 @@ void ThreadPool::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_thread_fallback_count", "value"), &ThreadPool::set_thread_fallback_count);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "thread_fallback_count"), "set_thread_fallback_count", "get_thread_fallback_count");
 
+	ClassDB::bind_method(D_METHOD("get_use_engine_worker_pool"), &ThreadPool::get_use_engine_worker_pool);
+	ClassDB::bind_method(D_METHOD("set_use_engine_worker_pool", "value"), &ThreadPool::set_use_engine_worker_pool);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_engine_worker_pool"), "set_use_engine_worker_pool", "get_use_engine_worker_pool");
+
 	ClassDB::bind_method(D_METHOD("get_max_time_per_frame"), &ThreadPool::get_max_time_per_frame);
 	ClassDB::bind_method(D_METHOD("set_max_time_per_frame", "value"), &ThreadPool::set_max_time_per_frame);
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "max_time_per_frame"), "set_max_time_per_frame", "get_max_time_per_frame");
@@ -463,17 +2748,114 @@ void ThreadPool::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("apply_max_work_per_frame_percent"), &ThreadPool::apply_max_work_per_frame_percent);
 
+	ClassDB::bind_method(D_METHOD("get_missed_deadline_count"), &ThreadPool::get_missed_deadline_count);
+	ClassDB::bind_method(D_METHOD("get_total_missed_deadline_count"), &ThreadPool::get_total_missed_deadline_count);
+
 	ClassDB::bind_method(D_METHOD("is_working"), &ThreadPool::is_working);
 	ClassDB::bind_method(D_METHOD("is_working_no_lock"), &ThreadPool::is_working_no_lock);
 
+	ClassDB::bind_method(D_METHOD("get_pending_count"), &ThreadPool::get_pending_count);
+	ClassDB::bind_method(D_METHOD("get_active_count"), &ThreadPool::get_active_count);
+
 	ClassDB::bind_method(D_METHOD("has_job", "job"), &ThreadPool::has_job);
 	ClassDB::bind_method(D_METHOD("add_job", "job"), &ThreadPool::add_job);
+	ClassDB::bind_method(D_METHOD("add_job_to_worker", "job", "worker_index"), &ThreadPool::add_job_to_worker);
+
+	ClassDB::bind_method(D_METHOD("add_job_with_policy", "job", "policy"), &ThreadPool::add_job_with_policy);
+	ClassDB::bind_method(D_METHOD("add_job_with_future", "job"), &ThreadPool::add_job_with_future);
+
+	ClassDB::bind_method(D_METHOD("get_queue_capacity"), &ThreadPool::get_queue_capacity);
+	ClassDB::bind_method(D_METHOD("set_queue_capacity", "value"), &ThreadPool::set_queue_capacity);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "queue_capacity"), "set_queue_capacity", "get_queue_capacity");
+
+	ClassDB::bind_method(D_METHOD("get_coalesce_policy"), &ThreadPool::get_coalesce_policy);
+	ClassDB::bind_method(D_METHOD("set_coalesce_policy", "value"), &ThreadPool::set_coalesce_policy);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "coalesce_policy", PROPERTY_HINT_ENUM, "Keep Newest,Keep Oldest"), "set_coalesce_policy", "get_coalesce_policy");
+
+	ClassDB::bind_method(D_METHOD("get_micro_batch_size"), &ThreadPool::get_micro_batch_size);
+	ClassDB::bind_method(D_METHOD("set_micro_batch_size", "value"), &ThreadPool::set_micro_batch_size);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "micro_batch_size"), "set_micro_batch_size", "get_micro_batch_size");
+
+	ClassDB::bind_method(D_METHOD("get_micro_batch_window"), &ThreadPool::get_micro_batch_window);
+	ClassDB::bind_method(D_METHOD("set_micro_batch_window", "value"), &ThreadPool::set_micro_batch_window);
+	ADD_PROPERTY(PropertyInfo(Variant::REAL, "micro_batch_window"), "set_micro_batch_window", "get_micro_batch_window");
+
+	ClassDB::bind_method(D_METHOD("get_category_limit", "category"), &ThreadPool::get_category_limit);
+	ClassDB::bind_method(D_METHOD("set_category_limit", "category", "max_running"), &ThreadPool::set_category_limit);
+	ClassDB::bind_method(D_METHOD("get_category_running_count", "category"), &ThreadPool::get_category_running_count);
+
+	ClassDB::bind_method(D_METHOD("get_queue_full_policy"), &ThreadPool::get_queue_full_policy);
+	ClassDB::bind_method(D_METHOD("set_queue_full_policy", "value"), &ThreadPool::set_queue_full_policy);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "queue_full_policy", PROPERTY_HINT_ENUM, "Block,Fail,Drop Oldest,Drop Lowest Priority"), "set_queue_full_policy", "get_queue_full_policy");
+
+	ClassDB::bind_method(D_METHOD("add_job_delayed", "job", "delay"), &ThreadPool::add_job_delayed);
+	ClassDB::bind_method(D_METHOD("add_job_repeating", "job", "interval"), &ThreadPool::add_job_repeating);
 
 	ClassDB::bind_method(D_METHOD("cancel_job", "job"), &ThreadPool::cancel_job);
 	ClassDB::bind_method(D_METHOD("cancel_job_wait", "job"), &ThreadPool::cancel_job_wait);
 
+	ClassDB::bind_method(D_METHOD("acquire_execute_job"), &ThreadPool::acquire_execute_job);
+
+	ClassDB::bind_method(D_METHOD("get_current_worker_index"), &ThreadPool::get_current_worker_index);
+
+	ClassDB::bind_method(D_METHOD("get_worker_data", "name", "default_value"), &ThreadPool::get_worker_data, DEFVAL(Variant()));
+	ClassDB::bind_method(D_METHOD("set_worker_data", "name", "value"), &ThreadPool::set_worker_data);
+	ClassDB::bind_method(D_METHOD("has_worker_data", "name"), &ThreadPool::has_worker_data);
+
+	ClassDB::bind_method(D_METHOD("take_scratch_bytes", "size"), &ThreadPool::take_scratch_bytes);
+	ClassDB::bind_method(D_METHOD("return_scratch_bytes", "array"), &ThreadPool::return_scratch_bytes);
+	ClassDB::bind_method(D_METHOD("take_scratch_floats", "size"), &ThreadPool::take_scratch_floats);
+	ClassDB::bind_method(D_METHOD("return_scratch_floats", "array"), &ThreadPool::return_scratch_floats);
+
+	ClassDB::bind_method(D_METHOD("get_worker_arena_size"), &ThreadPool::get_worker_arena_size);
+	ClassDB::bind_method(D_METHOD("set_worker_arena_size", "value"), &ThreadPool::set_worker_arena_size);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "worker_arena_size"), "set_worker_arena_size", "get_worker_arena_size");
+
+	ClassDB::bind_method(D_METHOD("get_worker_priority"), &ThreadPool::get_worker_priority);
+	ClassDB::bind_method(D_METHOD("set_worker_priority", "value"), &ThreadPool::set_worker_priority);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "worker_priority", PROPERTY_HINT_ENUM, "Normal,Low,Background,High"), "set_worker_priority", "get_worker_priority");
+
+	ClassDB::bind_method(D_METHOD("get_worker_thread_priority", "worker_index"), &ThreadPool::get_worker_thread_priority);
+	ClassDB::bind_method(D_METHOD("set_worker_thread_priority", "worker_index", "value"), &ThreadPool::set_worker_thread_priority);
+	ClassDB::bind_method(D_METHOD("clear_worker_thread_priorities"), &ThreadPool::clear_worker_thread_priorities);
+
+	ClassDB::bind_method(D_METHOD("parallel_sort_floats", "array"), &ThreadPool::parallel_sort_floats);
+	ClassDB::bind_method(D_METHOD("parallel_sort_ints", "array"), &ThreadPool::parallel_sort_ints);
+	ClassDB::bind_method(D_METHOD("parallel_sum_floats", "array"), &ThreadPool::parallel_sum_floats);
+	ClassDB::bind_method(D_METHOD("parallel_min_floats", "array"), &ThreadPool::parallel_min_floats);
+	ClassDB::bind_method(D_METHOD("parallel_max_floats", "array"), &ThreadPool::parallel_max_floats);
+	ClassDB::bind_method(D_METHOD("parallel_prefix_sum_floats", "array"), &ThreadPool::parallel_prefix_sum_floats);
+
+	ClassDB::bind_method(D_METHOD("get_execute_job_pool_size"), &ThreadPool::get_execute_job_pool_size);
+	ClassDB::bind_method(D_METHOD("set_execute_job_pool_size", "value"), &ThreadPool::set_execute_job_pool_size);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "execute_job_pool_size"), "set_execute_job_pool_size", "get_execute_job_pool_size");
+
 	ClassDB::bind_method(D_METHOD("register_update"), &ThreadPool::register_update);
 	ClassDB::bind_method(D_METHOD("unregister_update"), &ThreadPool::unregister_update);
 
+	ClassDB::bind_method(D_METHOD("get_sync_stats_enabled"), &ThreadPool::get_sync_stats_enabled);
+	ClassDB::bind_method(D_METHOD("set_sync_stats_enabled", "value"), &ThreadPool::set_sync_stats_enabled);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "sync_stats_enabled"), "set_sync_stats_enabled", "get_sync_stats_enabled");
+
+	ClassDB::bind_method(D_METHOD("get_sync_stats"), &ThreadPool::get_sync_stats);
+	ClassDB::bind_method(D_METHOD("reset_sync_stats"), &ThreadPool::reset_sync_stats);
+	ClassDB::bind_method(D_METHOD("print_sync_stats"), &ThreadPool::print_sync_stats);
+
 	ClassDB::bind_method(D_METHOD("update"), &ThreadPool::update);
+
+	ADD_SIGNAL(MethodInfo("deadlines_missed", PropertyInfo(Variant::INT, "count")));
+	ADD_SIGNAL(MethodInfo("queue_pressure"));
+
+	BIND_ENUM_CONSTANT(QUEUE_FULL_POLICY_BLOCK);
+	BIND_ENUM_CONSTANT(QUEUE_FULL_POLICY_FAIL);
+	BIND_ENUM_CONSTANT(QUEUE_FULL_POLICY_DROP_OLDEST);
+	BIND_ENUM_CONSTANT(QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY);
+
+	BIND_ENUM_CONSTANT(WORKER_PRIORITY_NORMAL);
+	BIND_ENUM_CONSTANT(WORKER_PRIORITY_LOW);
+	BIND_ENUM_CONSTANT(WORKER_PRIORITY_BACKGROUND);
+	BIND_ENUM_CONSTANT(WORKER_PRIORITY_HIGH);
+
+	BIND_ENUM_CONSTANT(COALESCE_POLICY_KEEP_NEWEST);
+	BIND_ENUM_CONSTANT(COALESCE_POLICY_KEEP_OLDEST);
 }
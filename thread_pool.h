@@ -29,20 +29,39 @@ SOFTWARE.
 
 #if VERSION_MAJOR > 3
 #include "core/object/object.h"
+#include "core/templates/hash_map.h"
 #include "core/templates/list.h"
+#include "core/templates/safe_refcount.h"
 #include "core/templates/vector.h"
+#include "core/variant/variant.h"
 #else
+#include "core/hash_map.h"
 #include "core/list.h"
 #include "core/object.h"
+#include "core/safe_refcount.h"
+#include "core/variant.h"
 #include "core/vector.h"
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#if VERSION_MAJOR > 3
+#include "core/object/worker_thread_pool.h"
+#endif
+
+#include "core/os/mutex.h"
 #include "core/os/semaphore.h"
 #include "core/os/thread.h"
 #include "core/os/thread_safe.h"
 #include "core/version.h"
+#include "thread_pool_arena.h"
 #include "thread_pool_execute_job.h"
 #include "thread_pool_job.h"
+#include "thread_pool_job_queue.h"
+#include "thread_pool_task.h"
+#include "thread_pool_timer_wheel.h"
 
 class ThreadPool : public Object {
 	GDCLASS(ThreadPool, Object);
@@ -50,20 +69,168 @@ class ThreadPool : public Object {
 	_THREAD_SAFE_CLASS_
 
 protected:
-	struct ThreadPoolContext {
+	enum {
+		TASK_CHUNK_SIZE = 256,
+		CACHE_LINE_SIZE = 64,
+		MAILBOX_SIZE = 64,
+		MAILBOX_MASK = MAILBOX_SIZE - 1,
+		//How many queued jobs a worker looks at, when searching for one with its affinity
+		AFFINITY_SCAN_DEPTH = 8,
+	};
+
+	// Single producer (the main thread, under the lock), single consumer (the worker, without the lock) ring buffer.
+	// Holds a reference to every job in it.
+	struct ThreadPoolMailbox {
+		alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head;
+		alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> tail;
+		ThreadPoolJob *jobs[MAILBOX_SIZE];
+
+		bool push(ThreadPoolJob *job) {
+			uint32_t t = tail.load(std::memory_order_relaxed);
+
+			if (t - head.load(std::memory_order_acquire) >= MAILBOX_SIZE) {
+				return false;
+			}
+
+			jobs[t & MAILBOX_MASK] = job;
+			tail.store(t + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		ThreadPoolJob *pop() {
+			uint32_t h = head.load(std::memory_order_relaxed);
+
+			if (h == tail.load(std::memory_order_acquire)) {
+				return NULL;
+			}
+
+			ThreadPoolJob *job = jobs[h & MAILBOX_MASK];
+			head.store(h + 1, std::memory_order_release);
+
+			return job;
+		}
+
+		bool empty() const {
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+		ThreadPoolMailbox() {
+			head.store(0);
+			tail.store(0);
+		}
+	};
+
+	// Scratch memory of a thread. The arena is reset when the outermost job that runs on the thread finishes,
+	// jobs can run other jobs while waiting (for example in wait_task), these must not reset it.
+	struct ThreadPoolScratch {
+		ThreadPoolArena arena;
+#if VERSION_MAJOR < 4
+		PoolByteArray bytes;
+		PoolRealArray floats;
+#else
+		PackedByteArray bytes;
+		PackedFloat32Array floats;
+#endif
+		//Not reset, lives as long as the thread
+		HashMap<StringName, Variant> worker_data;
+
+		//Jobs spawned by the jobs running on this thread. The owner pops the back, thieves take the front
+		Mutex spawn_lock;
+		ThreadPoolJobQueue spawned_jobs;
+
+		int depth;
+
+		void begin() {
+			++depth;
+		}
+
+		void end() {
+			if (--depth == 0) {
+				arena.reset();
+			}
+		}
+
+		ThreadPoolScratch() {
+			depth = 0;
+		}
+	};
+
+	// Contexts are stored in one cache line aligned array, so workers don't share cache lines.
+	// job and task are only assigned under the lock, but the worker and cancel_job_wait read them without it.
+	// mailbox_job is the job the worker popped from its mailbox, the worker sets it without the lock.
+	// An assigned job holds a reference.
+	struct alignas(CACHE_LINE_SIZE) ThreadPoolContext {
 		Thread *thread;
 		Semaphore *semaphore;
-		Ref<ThreadPoolJob> job;
-		bool running;
+		int index;
+		int priority;
+		SafeFlag running;
+		std::atomic<ThreadPoolJob *> job;
+		std::atomic<ThreadPoolTask *> task;
+		std::atomic<ThreadPoolJob *> mailbox_job;
+		ThreadPoolMailbox mailbox;
+		ThreadPoolScratch scratch;
+
+		//Wake ups that weren't handled yet, when the engine's WorkerThreadPool runs the context.
+		//Only the task that raises it from 0 is added, so a context never runs on two threads at once
+		SafeNumeric<uint32_t> engine_wakeups;
+
+		//Sync stats, only updated when they are enabled
+		SafeNumeric<uint64_t> wake_posted_usec;
+		SafeNumeric<uint64_t> wake_count;
+		SafeNumeric<uint64_t> wake_latency_usec;
+		SafeNumeric<uint64_t> wake_latency_max_usec;
+		SafeNumeric<uint64_t> assigned_usec;
+		SafeNumeric<uint64_t> assign_count;
+		SafeNumeric<uint64_t> assign_latency_usec;
+		SafeNumeric<uint64_t> assign_latency_max_usec;
+
+		bool is_idle() const {
+			return !job.load() && !task.load() && !mailbox_job.load();
+		}
 
 		ThreadPoolContext() {
 			thread = NULL;
 			semaphore = NULL;
-			running = false;
+			index = 0;
+			priority = 0;
+			job.store(NULL);
+			task.store(NULL);
+			mailbox_job.store(NULL);
 		}
 	};
 
 public:
+#if VERSION_MAJOR < 4
+	typedef PoolRealArray FloatArray;
+	typedef real_t FloatArrayItem;
+	typedef PoolIntArray IntArray;
+#else
+	typedef PackedFloat32Array FloatArray;
+	typedef float FloatArrayItem;
+	typedef PackedInt32Array IntArray;
+#endif
+
+	enum QueueFullPolicy {
+		QUEUE_FULL_POLICY_BLOCK = 0,
+		QUEUE_FULL_POLICY_FAIL,
+		QUEUE_FULL_POLICY_DROP_OLDEST,
+		QUEUE_FULL_POLICY_DROP_LOWEST_PRIORITY,
+	};
+
+	enum WorkerPriority {
+		WORKER_PRIORITY_NORMAL = 0,
+		WORKER_PRIORITY_LOW,
+		WORKER_PRIORITY_BACKGROUND,
+		WORKER_PRIORITY_HIGH,
+	};
+
+	enum CoalescePolicy {
+		COALESCE_POLICY_KEEP_NEWEST = 0,
+		COALESCE_POLICY_KEEP_OLDEST,
+	};
+
 	static ThreadPool *get_singleton();
 
 	bool get_use_threads() const;
@@ -75,6 +242,11 @@ public:
 	int get_thread_fallback_count() const;
 	void set_thread_fallback_count(const int value);
 
+	// Godot 4 only. Runs the workers on the engine's WorkerThreadPool, instead of creating threads.
+	// thread_count then limits how many engine threads the pool uses at once
+	bool get_use_engine_worker_pool() const;
+	void set_use_engine_worker_pool(const bool value);
+
 	float get_max_time_per_frame() const;
 	void set_max_time_per_frame(const float value);
 
@@ -86,17 +258,156 @@ public:
 
 	void apply_max_work_per_frame_percent();
 
+	int get_missed_deadline_count() const;
+	int get_total_missed_deadline_count() const;
+
 	bool is_working() const;
 	bool is_working_no_lock() const;
 
+	int get_pending_count() const;
+	int get_active_count() const;
+
 	bool has_job(const Ref<ThreadPoolJob> &job);
 	void add_job(const Ref<ThreadPoolJob> &job);
+	void add_job_to_worker(const Ref<ThreadPoolJob> &job, const int worker_index);
+	bool add_job_with_policy(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy);
+	Ref<ThreadPoolFuture> add_job_with_future(const Ref<ThreadPoolJob> &job);
+
+	// Only covers jobs waiting in the shared queue (including the ones with a deadline).
+	// Jobs handed to an idle worker right away, jobs in worker mailboxes (add_job_to_worker),
+	// micro jobs, spawned children, and native tasks don't count. A mailbox job whose category is saturated
+	// is moved to the shared queue, that goes through the capacity check (it can't block, it fails instead).
+	int get_queue_capacity() const;
+	void set_queue_capacity(const int value);
+
+	QueueFullPolicy get_queue_full_policy() const;
+	void set_queue_full_policy(const QueueFullPolicy value);
+
+	// What add_job does, when a job with the same coalesce_key is still queued
+	CoalescePolicy get_coalesce_policy() const;
+	void set_coalesce_policy(const CoalescePolicy value);
+
+	// Micro jobs are collected into a batch, that is run by one worker, when it's full, or its window passed
+	int get_micro_batch_size() const;
+	void set_micro_batch_size(const int value);
+
+	float get_micro_batch_window() const;
+	void set_micro_batch_window(const float value);
+
+	// 0 means no limit
+	int get_category_limit(const StringName &category) const;
+	void set_category_limit(const StringName &category, const int max_running);
+	int get_category_running_count(const StringName &category) const;
+
+	void add_job_delayed(const Ref<ThreadPoolJob> &job, const float delay);
+	void add_job_repeating(const Ref<ThreadPoolJob> &job, const float interval);
 
 	void cancel_job(Ref<ThreadPoolJob> job);
 	void cancel_job_wait(Ref<ThreadPoolJob> job);
 
-	void _thread_finished(ThreadPoolContext *context);
+	// Pooled jobs are taken back when they finish, don't hold onto them after adding them
+	Ref<ThreadPoolExecuteJob> acquire_execute_job();
+
+	int get_execute_job_pool_size() const;
+	void set_execute_job_pool_size(const int value);
+
+	// Runs a C++ callable on the pool, without creating a ThreadPoolJob.
+	// The callable is stored inline in a recycled task slot if it's small enough.
+	template <class F>
+	ThreadPoolTaskFuture submit(F &&f) {
+		_lock_pool();
+
+		ThreadPoolTask *task = _acquire_task_no_lock();
+		task->set(std::forward<F>(f));
+
+		ThreadPoolTaskFuture future(task, task->generation.get());
+
+		_submit_task_no_lock(task);
+
+		_unlock_pool();
+
+		return future;
+	}
+
+	void wait_task(const ThreadPoolTaskFuture &future);
+
+	// Runs one queued job or task on the calling thread, so waiting threads can help out instead of blocking.
+	// Without threads only the main thread can help, by calling update(), except from a job update() runs.
+	// Returns false if nothing was run.
+	bool help_run_job();
+
+	// Scratch memory of the current worker thread (or the main thread), it's reset after every job.
+	// Returns NULL on other threads.
+	static ThreadPoolArena *get_current_arena();
+
+	// Used by ThreadPoolJob::spawn() and sync()
+	void spawn_job(ThreadPoolJob *parent, const Ref<ThreadPoolJob> &child);
+	void sync_jobs(ThreadPoolJob *parent);
+
+	// Index of the worker thread the caller runs on, -1 if it's not a worker
+	int get_current_worker_index() const;
+
+	// Per thread storage, so jobs can keep state (generators, caches) between runs without locking.
+	// Works on worker threads and the main thread. Recreating the workers (apply_settings) clears it.
+	Variant get_worker_data(const StringName &name, const Variant &default_value = Variant()) const;
+	void set_worker_data(const StringName &name, const Variant &value);
+	bool has_worker_data(const StringName &name) const;
+
+	// The array is moved out, so scripts can write it without copying. Give it back using return_scratch_*
+	// so the next job on the same thread can reuse the allocation.
+#if VERSION_MAJOR < 4
+	PoolByteArray take_scratch_bytes(const int size);
+	void return_scratch_bytes(const PoolByteArray &array);
+
+	PoolRealArray take_scratch_floats(const int size);
+	void return_scratch_floats(const PoolRealArray &array);
+#else
+	PackedByteArray take_scratch_bytes(const int size);
+	void return_scratch_bytes(const PackedByteArray &array);
+
+	PackedFloat32Array take_scratch_floats(const int size);
+	void return_scratch_floats(const PackedFloat32Array &array);
+#endif
+
+	int get_worker_arena_size() const;
+	void set_worker_arena_size(const int value);
+
+	// OS scheduling priority of the worker threads, only applied on Linux, when the threads are created.
+	// Single workers can be overridden, for example to have a latency critical lane.
+	WorkerPriority get_worker_priority() const;
+	void set_worker_priority(const WorkerPriority value);
+
+	WorkerPriority get_worker_thread_priority(const int worker_index) const;
+	void set_worker_thread_priority(const int worker_index, const WorkerPriority value);
+	void clear_worker_thread_priorities();
+
+	// Script versions of ThreadPoolParallel's algorithms, the arrays are copied
+	FloatArray parallel_sort_floats(const FloatArray &array);
+	IntArray parallel_sort_ints(const IntArray &array);
+	real_t parallel_sum_floats(const FloatArray &array);
+	real_t parallel_min_floats(const FloatArray &array);
+	real_t parallel_max_floats(const FloatArray &array);
+	FloatArray parallel_prefix_sum_floats(const FloatArray &array);
+
+	// Opt-in counters for the pool's lock, and for the hand off of work to the workers
+	bool get_sync_stats_enabled() const;
+	void set_sync_stats_enabled(const bool value);
+
+	Dictionary get_sync_stats() const;
+	void reset_sync_stats();
+	void print_sync_stats() const;
+
+	void _thread_finished(ThreadPoolContext *context, ThreadPoolJob *job, ThreadPoolTask *task, const bool from_mailbox);
 	static void _worker_thread_func(void *user_data);
+	static void _engine_task_func(void *user_data);
+	static void _apply_thread_priority(const int priority);
+	void _run_context(ThreadPoolContext *context);
+	ThreadPoolJob *_start_mailbox_job(ThreadPoolContext *context);
+
+	void _process_timers();
+	void _flush_expired_micro_batch();
+	void _timer_thread_loop();
+	static void _timer_thread_func(void *user_data);
 
 	void register_update();
 	void unregister_update();
@@ -110,10 +421,79 @@ public:
 protected:
 	static void _bind_methods();
 
+	void _prepare_job(const Ref<ThreadPoolJob> &job);
+	bool _assign_to_idle_context_no_lock(const Ref<ThreadPoolJob> &job);
+	bool _dispatch_no_lock(ThreadPoolContext *context);
+	void _dispatch_to_idle_contexts_no_lock();
+
+	bool _is_category_available_no_lock(const ThreadPoolJob *job) const;
+	void _category_job_started_no_lock(const ThreadPoolJob *job);
+	bool _category_job_finished_no_lock(const ThreadPoolJob *job);
+
+	void _create_contexts(const int count);
+	void _detach_contexts_no_lock(ThreadPoolContext **r_contexts, void **r_contexts_memory, int *r_context_count);
+	void _free_contexts(ThreadPoolContext *contexts, void *contexts_memory, const int context_count);
+	void _wake_context(ThreadPoolContext *context);
+	void _context_woken(ThreadPoolContext *context);
+
+	// Every lock of the pool goes through these, so sync stats can measure the wait, if they are enabled
+	void _lock_pool() const;
+	void _unlock_pool() const;
+	void _reap_engine_tasks(const bool wait);
+
+	bool _enqueue_job_no_lock(const Ref<ThreadPoolJob> &job);
+	bool _insert_job_no_lock(const Ref<ThreadPoolJob> &job);
+	ThreadPoolJob *_take_job_no_lock(const int worker_index = -1);
+	int _get_affinity_worker_no_lock(const ThreadPoolJob *job) const;
+	bool _add_job_no_lock(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy);
+	bool _add_prepared_job_no_lock(const Ref<ThreadPoolJob> &job, const QueueFullPolicy policy);
+	bool _has_job_no_lock(const Ref<ThreadPoolJob> &job) const;
+	bool _is_job_running_no_lock(const Ref<ThreadPoolJob> &job) const;
+	bool _cancel_job_no_lock(const Ref<ThreadPoolJob> &job);
+	bool _erase_job_no_lock(const Ref<ThreadPoolJob> &job);
+	bool _coalesce_job_no_lock(const Ref<ThreadPoolJob> &job);
+	void _unindex_coalesce_key_no_lock(const ThreadPoolJob *job);
+	void _discard_job_no_lock(const Ref<ThreadPoolJob> &job);
+	int _get_queued_job_count_no_lock() const;
+	void _update_queue_pressure_no_lock();
+	void _wake_blocked_producer_no_lock();
+	void _wake_all_blocked_producers_no_lock();
+	bool _can_block_on_full_queue_no_lock() const;
+	void _job_finished_no_lock(const Ref<ThreadPoolJob> &job);
+	void _recycle_execute_job_no_lock(ThreadPoolJob *job);
+	void _add_micro_job_no_lock(const Ref<ThreadPoolJob> &job);
+	void _flush_micro_batch_no_lock();
+	void _run_micro_batch(ThreadPoolJobQueue *batch);
+	void _report_missed_deadlines();
+	void _resolve_futures();
+
+	// check_categories needs the pool's lock
+	ThreadPoolJob *_steal_spawned_job(const ThreadPoolScratch *except, const bool check_categories = false);
+	void _run_spawned_job(ThreadPoolJob *job);
+	void _run_taken_job(ThreadPoolJob *job);
+
+	ThreadPoolTask *_acquire_task_no_lock();
+	void _submit_task_no_lock(ThreadPoolTask *task);
+	ThreadPoolTask *_pop_task_no_lock();
+	void _release_task_no_lock(ThreadPoolTask *task);
+	void _run_task(ThreadPoolTask *task);
+
+	void _add_timer(const Ref<ThreadPoolJob> &job, const float delay, const float interval);
+	void _add_timer_no_lock(const Ref<ThreadPoolJob> &job, const uint64_t delay_ticks, const uint64_t interval_ticks);
+	bool _requeue_job_no_lock(const Ref<ThreadPoolJob> &job);
+	uint64_t _seconds_to_timer_ticks(const float seconds) const;
+	uint64_t _get_timer_tick() const;
+
+	void _start_timer_thread();
+	void _stop_timer_thread();
+	void _wake_timer_thread();
+
 private:
 	static ThreadPool *_instance;
 
 	bool _dirty;
+	// Set while update() runs jobs without threads
+	bool _updating;
 	bool _use_threads;
 	bool _use_threads_new;
 	int _thread_count;
@@ -122,9 +502,108 @@ private:
 	float _max_time_per_frame;
 	float _target_fps;
 
-	Vector<ThreadPoolContext *> _threads;
+	void *_contexts_memory;
+	ThreadPoolContext *_contexts;
+	int _context_count;
+
+	ThreadPoolJobQueue _queue;
+	ThreadPoolJobQueue _deadline_queue;
+
+	//Queued jobs and tasks (including mailboxes), and the ones that are currently assigned to a worker.
+	//A job is counted as active before it stops being pending, so is_working() can't see a gap without the lock.
+	SafeNumeric<uint32_t> _pending_count;
+	SafeNumeric<uint32_t> _active_count;
+
+	//0 means unbounded. Only counts jobs in _queue and _deadline_queue
+	int _queue_capacity;
+	QueueFullPolicy _queue_full_policy;
+	bool _queue_under_pressure;
+
+	struct CategoryState {
+		int limit;
+		int running;
+
+		CategoryState() {
+			limit = 0;
+			running = 0;
+		}
+	};
+
+	HashMap<StringName, CategoryState> _categories;
+	int _limited_category_count;
+
+	//Queued (not running) jobs that have a coalesce_key
+	HashMap<StringName, ThreadPoolJob *> _coalesce_index;
+	CoalescePolicy _coalesce_policy;
+
+	//The open batch, NULL if there is none. Its jobs count as pending until the batch finishes
+	ThreadPoolJobQueue *_micro_batch;
+	// Submitted as a task, but not finished yet
+	Vector<ThreadPoolJobQueue *> _flushed_micro_batches;
+	uint64_t _micro_batch_start_usec;
+	int _micro_batch_size;
+	float _micro_batch_window;
+
+	// Jobs taken from the queue by help_run_job, they run outside of the contexts
+	Vector<ThreadPoolJob *> _helper_jobs;
+
+	Vector<ThreadPoolTask *> _task_chunks;
+	ThreadPoolTask *_free_tasks;
+	ThreadPoolTask *_task_queue_head;
+	ThreadPoolTask *_task_queue_tail;
 
-	List<Ref<ThreadPoolJob>> _queue;
+	List<Ref<ThreadPoolJob>> _finished_future_jobs;
+
+	Vector<Ref<ThreadPoolExecuteJob>> _execute_job_pool;
+	int _execute_job_pool_size;
+
+	static thread_local ThreadPoolScratch *_current_scratch;
+	static thread_local int _current_worker_index;
+	ThreadPoolScratch _main_scratch;
+	int _worker_arena_size;
+
+	WorkerPriority _worker_priority;
+	//-1 means the worker uses _worker_priority
+	Vector<int> _worker_priority_overrides;
+
+	int _missed_deadline_count;
+	int _missed_deadline_count_current_frame;
+	int _total_missed_deadline_count;
+
+	ThreadPoolTimerWheel _timer_wheel;
+	uint64_t _timer_start_usec;
+	int _timer_resolution_usec;
+	SafeFlag _timer_running;
+	Thread *_timer_thread;
+
+	// The timer thread sleeps until the next timer expires, or the micro batch window ends.
+	// Semaphores can't time out, that's why these are not engine types.
+	std::mutex _timer_wait_mutex;
+	std::condition_variable _timer_wait_condition;
+	bool _timer_wakeup;
+
+	// Producers waiting in add_job, because of QUEUE_FULL_POLICY_BLOCK
+	int _blocked_producer_count;
+	Semaphore *_blocked_producer_semaphore;
+
+	bool _use_engine_worker_pool;
+	bool _use_engine_worker_pool_new;
+
+	SafeFlag _sync_stats_enabled;
+	mutable SafeNumeric<uint64_t> _sync_lock_count;
+	mutable SafeNumeric<uint64_t> _sync_lock_contention_count;
+	mutable SafeNumeric<uint64_t> _sync_lock_wait_usec;
+	mutable SafeNumeric<uint64_t> _sync_lock_wait_max_usec;
+
+#if VERSION_MAJOR > 3
+	//Engine tasks have to be waited for, otherwise they are never freed
+	Mutex _engine_task_lock;
+	Vector<WorkerThreadPool::TaskID> _engine_tasks;
+#endif
 };
 
+VARIANT_ENUM_CAST(ThreadPool::QueueFullPolicy);
+VARIANT_ENUM_CAST(ThreadPool::WorkerPriority);
+VARIANT_ENUM_CAST(ThreadPool::CoalescePolicy);
+
 #endif
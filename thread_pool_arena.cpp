@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_arena.h"
+
+void *ThreadPoolArena::alloc(const size_t size, const size_t alignment) {
+	ERR_FAIL_COND_V(alignment == 0 || (alignment & (alignment - 1)) != 0, NULL);
+
+	uintptr_t mask = static_cast<uintptr_t>(alignment - 1);
+	uint8_t *ptr = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(_pos) + mask) & ~mask);
+
+	if (!_blocks || ptr + size > _end) {
+		_add_block(MAX(_block_size, size + alignment));
+
+		ptr = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(_pos) + mask) & ~mask);
+	}
+
+	_used += (ptr - _pos) + size;
+	_pos = ptr + size;
+
+	return ptr;
+}
+
+void ThreadPoolArena::reset() {
+	if (!_blocks) {
+		return;
+	}
+
+	if (_blocks->next) {
+		size_t capacity = _capacity;
+
+		_free_blocks();
+		_add_block(capacity);
+	}
+
+	_pos = _blocks->data();
+	_end = _pos + _blocks->size;
+	_used = 0;
+}
+
+size_t ThreadPoolArena::get_used() const {
+	return _used;
+}
+
+size_t ThreadPoolArena::get_capacity() const {
+	return _capacity;
+}
+
+size_t ThreadPoolArena::get_block_size() const {
+	return _block_size;
+}
+void ThreadPoolArena::set_block_size(const size_t value) {
+	ERR_FAIL_COND(value == 0);
+
+	_block_size = value;
+}
+
+void ThreadPoolArena::_add_block(const size_t size) {
+	Block *block = reinterpret_cast<Block *>(memalloc(sizeof(Block) + size));
+
+	block->next = _blocks;
+	block->size = size;
+
+	_blocks = block;
+	_pos = block->data();
+	_end = _pos + size;
+
+	_capacity += size;
+}
+
+void ThreadPoolArena::_free_blocks() {
+	while (_blocks) {
+		Block *next = _blocks->next;
+		memfree(_blocks);
+		_blocks = next;
+	}
+
+	_pos = NULL;
+	_end = NULL;
+	_used = 0;
+	_capacity = 0;
+}
+
+ThreadPoolArena::ThreadPoolArena() {
+	_blocks = NULL;
+	_pos = NULL;
+	_end = NULL;
+
+	_used = 0;
+	_capacity = 0;
+	_block_size = DEFAULT_BLOCK_SIZE;
+}
+
+ThreadPoolArena::~ThreadPoolArena() {
+	_free_blocks();
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_ARENA_H
+#define THREAD_POOL_ARENA_H
+
+#include "core/os/memory.h"
+#include "core/typedefs.h"
+
+// Linear (bump) allocator. Every worker thread has one, that is reset after each job,
+// so jobs can allocate temporary buffers without going through the global allocator.
+// Nothing is freed individually, and destructors are not called. Not thread safe.
+class ThreadPoolArena {
+public:
+	enum {
+		DEFAULT_BLOCK_SIZE = 65536,
+		DEFAULT_ALIGNMENT = 16,
+	};
+
+	void *alloc(const size_t size, const size_t alignment = DEFAULT_ALIGNMENT);
+
+	// Constructors are not called
+	template <class T>
+	T *alloc_array(const int count) {
+		return reinterpret_cast<T *>(alloc(sizeof(T) * count, alignof(T)));
+	}
+
+	// Invalidates every allocation. If more than one block was needed, they are merged into one,
+	// so the next job fits into a single block.
+	void reset();
+
+	size_t get_used() const;
+	size_t get_capacity() const;
+
+	size_t get_block_size() const;
+	void set_block_size(const size_t value);
+
+	ThreadPoolArena();
+	~ThreadPoolArena();
+
+protected:
+	struct Block {
+		Block *next;
+		size_t size;
+
+		uint8_t *data() {
+			return reinterpret_cast<uint8_t *>(this + 1);
+		}
+	};
+
+	void _add_block(const size_t size);
+	void _free_blocks();
+
+private:
+	Block *_blocks;
+	uint8_t *_pos;
+	uint8_t *_end;
+
+	size_t _used;
+	size_t _capacity;
+	size_t _block_size;
+};
+
+#endif
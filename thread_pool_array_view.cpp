@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_array_view.h"
+
+Ref<ThreadPoolSharedArray> ThreadPoolArrayView::get_array() const {
+	return _array;
+}
+
+int ThreadPoolArrayView::get_offset() const {
+	return _offset;
+}
+
+int ThreadPoolArrayView::size() const {
+	return _size;
+}
+
+Variant ThreadPoolArrayView::get_value(const int index) const {
+	ERR_FAIL_INDEX_V(index, _size, Variant());
+	ERR_FAIL_COND_V(!_array.is_valid(), Variant());
+
+	return _array->get_value(_offset + index);
+}
+
+void ThreadPoolArrayView::set_value(const int index, const Variant &value) {
+	ERR_FAIL_INDEX(index, _size);
+	ERR_FAIL_COND(!_array.is_valid());
+
+	_array->set_value(_offset + index, value);
+}
+
+void ThreadPoolArrayView::setup(const Ref<ThreadPoolSharedArray> &array, const int offset, const int size) {
+	_array = array;
+	_offset = offset;
+	_size = size;
+}
+
+ThreadPoolArrayView::ThreadPoolArrayView() {
+	_offset = 0;
+	_size = 0;
+}
+
+ThreadPoolArrayView::~ThreadPoolArrayView() {
+}
+
+void ThreadPoolArrayView::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_array"), &ThreadPoolArrayView::get_array);
+	ClassDB::bind_method(D_METHOD("get_offset"), &ThreadPoolArrayView::get_offset);
+	ClassDB::bind_method(D_METHOD("size"), &ThreadPoolArrayView::size);
+
+	ClassDB::bind_method(D_METHOD("get_value", "index"), &ThreadPoolArrayView::get_value);
+	ClassDB::bind_method(D_METHOD("set_value", "index", "value"), &ThreadPoolArrayView::set_value);
+}
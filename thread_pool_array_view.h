@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_ARRAY_VIEW_H
+#define THREAD_POOL_ARRAY_VIEW_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/object/ref_counted.h"
+#ifndef Reference
+#define Reference RefCounted
+#endif
+#else
+#include "core/reference.h"
+#endif
+
+#include "thread_pool_shared_array.h"
+
+// A range of a ThreadPoolSharedArray. Created using ThreadPoolSharedArray::partition() or get_view().
+// Indices are relative to the start of the view. Writes go straight into the shared buffer.
+class ThreadPoolArrayView : public Reference {
+	GDCLASS(ThreadPoolArrayView, Reference);
+
+public:
+	Ref<ThreadPoolSharedArray> get_array() const;
+	int get_offset() const;
+	int size() const;
+
+	Variant get_value(const int index) const;
+	void set_value(const int index, const Variant &value);
+
+	// Raw pointer to the first element of the view, for C++ jobs
+	template <class T>
+	T *ptrw() const {
+		ERR_FAIL_COND_V(!_array.is_valid() || !_array->ptrw(), NULL);
+		ERR_FAIL_COND_V_MSG(_array->get_array_type() != ThreadPoolSharedArray::get_array_type_of<T>(), NULL, "ThreadPoolArrayView: T doesn't match the element type of the array!");
+
+		return reinterpret_cast<T *>(_array->ptrw()) + _offset;
+	}
+
+	void setup(const Ref<ThreadPoolSharedArray> &array, const int offset, const int size);
+
+	ThreadPoolArrayView();
+	~ThreadPoolArrayView();
+
+protected:
+	static void _bind_methods();
+
+private:
+	Ref<ThreadPoolSharedArray> _array;
+	int _offset;
+	int _size;
+};
+
+#endif
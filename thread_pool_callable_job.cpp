@@ -0,0 +1,228 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_callable_job.h"
+
+#if VERSION_MAJOR >= 4
+
+#include "core/object/class_db.h"
+#include "core/object/method_bind.h"
+#include "core/object/script_language.h"
+
+Callable ThreadPoolCallableJob::get_callable() const {
+	return _callable;
+}
+void ThreadPoolCallableJob::set_callable(const Callable &value) {
+	_callable = value;
+
+	_resolve();
+}
+
+Array ThreadPoolCallableJob::get_arguments() const {
+	Array arr;
+	arr.resize(_argcount);
+
+	for (int i = 0; i < _argcount; ++i) {
+		arr[i] = _args[i];
+	}
+
+	return arr;
+}
+void ThreadPoolCallableJob::set_arguments(const Array &value) {
+	_resize_arguments(value.size());
+
+	for (int i = 0; i < value.size(); ++i) {
+		_args[i] = value[i];
+	}
+}
+
+void ThreadPoolCallableJob::_execute() {
+	ERR_FAIL_COND(_callable.is_null());
+
+	Callable::CallError error;
+
+	if (_object_id.is_valid()) {
+		Object *obj = ObjectDB::get_instance(_object_id);
+
+		if (!obj) {
+			//The target got freed in the meantime
+			set_cancelled(true);
+			set_complete(true);
+			return;
+		}
+
+		if (_method_bind) {
+			set_result(_method_bind->call(obj, _argptrs, _argcount, error));
+			set_complete(true);
+			return;
+		}
+	}
+
+	Variant ret;
+	_callable.callp(_argptrs, _argcount, ret, error);
+
+	set_result(ret);
+	set_complete(true);
+}
+
+void ThreadPoolCallableJob::reset() {
+	ThreadPoolJob::reset();
+
+	_callable = Callable();
+	_object_id = ObjectID();
+	_method_bind = NULL;
+
+	_clear_arguments();
+}
+
+void ThreadPoolCallableJob::_setup(const Callable &p_callable, const Variant **p_args, int p_argcount) {
+	set_complete(false);
+	set_cancelled(false);
+	set_result(Variant());
+
+	_resize_arguments(p_argcount);
+
+	for (int i = 0; i < p_argcount; ++i) {
+		_args[i] = *p_args[i];
+	}
+
+	set_callable(p_callable);
+
+	if (_callable.is_null()) {
+		set_complete(true);
+
+		ERR_FAIL_MSG("ThreadPoolCallableJob: The callable is null!");
+	}
+}
+
+Variant ThreadPoolCallableJob::_setup_bind(const Variant **p_args, int p_argcount, Callable::CallError &r_error) {
+	if (p_argcount < 1) {
+		r_error.error = Callable::CallError::CALL_ERROR_TOO_FEW_ARGUMENTS;
+		r_error.argument = 1;
+		return Variant();
+	}
+
+	if (p_args[0]->get_type() != Variant::CALLABLE) {
+		r_error.error = Callable::CallError::CALL_ERROR_INVALID_ARGUMENT;
+		r_error.argument = 0;
+		r_error.expected = Variant::CALLABLE;
+		return Variant();
+	}
+
+	_setup(*p_args[0], p_argcount > 1 ? &p_args[1] : nullptr, p_argcount - 1);
+
+	r_error.error = Callable::CallError::CALL_OK;
+
+	return Variant();
+}
+
+void ThreadPoolCallableJob::_resolve() {
+	_object_id = ObjectID();
+	_method_bind = NULL;
+
+	if (_callable.is_null()) {
+		return;
+	}
+
+	//Lambdas and bound callables are called through the Callable itself, but their target is still checked
+	_object_id = _callable.get_object_id();
+
+	if (_callable.is_custom()) {
+		return;
+	}
+
+	Object *obj = _callable.get_object();
+
+	ERR_FAIL_COND(!obj);
+
+	StringName method = _callable.get_method();
+
+	//Script methods have to go through the script instance
+	if (obj->get_script_instance() && obj->get_script_instance()->has_method(method)) {
+		return;
+	}
+
+	_method_bind = ClassDB::get_method(obj->get_class_name(), method);
+}
+
+void ThreadPoolCallableJob::_resize_arguments(const int count) {
+	_clear_arguments();
+
+	if (count > INLINE_ARGS) {
+		_args = memnew_arr(Variant, count);
+		_argptrs = memnew_arr(const Variant *, count);
+	}
+
+	_argcount = count;
+
+	for (int i = 0; i < _argcount; ++i) {
+		_argptrs[i] = &_args[i];
+	}
+}
+
+void ThreadPoolCallableJob::_clear_arguments() {
+	if (_args != _inline_args) {
+		memdelete_arr(_args);
+		memdelete_arr(_argptrs);
+
+		_args = _inline_args;
+		_argptrs = _inline_argptrs;
+	} else {
+		//Don't keep the previous arguments alive
+		for (int i = 0; i < _argcount; ++i) {
+			_inline_args[i] = Variant();
+		}
+	}
+
+	_argcount = 0;
+}
+
+ThreadPoolCallableJob::ThreadPoolCallableJob() {
+	_method_bind = NULL;
+
+	_argcount = 0;
+	_args = _inline_args;
+	_argptrs = _inline_argptrs;
+}
+ThreadPoolCallableJob::~ThreadPoolCallableJob() {
+	_clear_arguments();
+}
+
+void ThreadPoolCallableJob::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_callable"), &ThreadPoolCallableJob::get_callable);
+	ClassDB::bind_method(D_METHOD("set_callable", "value"), &ThreadPoolCallableJob::set_callable);
+	ADD_PROPERTY(PropertyInfo(Variant::CALLABLE, "callable"), "set_callable", "get_callable");
+
+	ClassDB::bind_method(D_METHOD("get_arguments"), &ThreadPoolCallableJob::get_arguments);
+	ClassDB::bind_method(D_METHOD("set_arguments", "value"), &ThreadPoolCallableJob::set_arguments);
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "arguments"), "set_arguments", "get_arguments");
+
+	ClassDB::bind_method(D_METHOD("_execute"), &ThreadPoolCallableJob::_execute);
+
+	MethodInfo mi;
+	mi.arguments.push_back(PropertyInfo(Variant::CALLABLE, "callable"));
+
+	mi.name = "setup";
+	ClassDB::bind_vararg_method(METHOD_FLAGS_DEFAULT, "setup", &ThreadPoolCallableJob::_setup_bind, mi);
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_CALLABLE_JOB_H
+#define THREAD_POOL_CALLABLE_JOB_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR >= 4
+
+#include "core/object/object_id.h"
+#include "core/variant/callable.h"
+
+#include "thread_pool_job.h"
+
+class MethodBind;
+
+// Like ThreadPoolExecuteJob, but it takes a Callable, and any number of arguments.
+// The method is looked up once in setup, and the target is only referenced by ObjectID,
+// so a freed target just cancels the job.
+class ThreadPoolCallableJob : public ThreadPoolJob {
+	GDCLASS(ThreadPoolCallableJob, ThreadPoolJob);
+
+public:
+	enum {
+		// Arguments up to this count are stored inline, like in ThreadPoolExecuteJob, more go to the heap
+		INLINE_ARGS = 8,
+	};
+
+	Callable get_callable() const;
+	void set_callable(const Callable &value);
+
+	Array get_arguments() const;
+	void set_arguments(const Array &value);
+
+	void _execute();
+	void reset();
+
+	template <typename... VarArgs>
+	void setup(const Callable &p_callable, VarArgs... p_args) {
+		Variant args[sizeof...(p_args) + 1] = { p_args..., Variant() }; // +1 makes sure zero sized arrays are also supported.
+		const Variant *argptrs[sizeof...(p_args) + 1];
+		for (uint32_t i = 0; i < sizeof...(p_args); i++) {
+			argptrs[i] = &args[i];
+		}
+		_setup(p_callable, sizeof...(p_args) == 0 ? nullptr : (const Variant **)argptrs, sizeof...(p_args));
+	}
+
+	void _setup(const Callable &p_callable, const Variant **p_args, int p_argcount);
+	Variant _setup_bind(const Variant **p_args, int p_argcount, Callable::CallError &r_error);
+
+	ThreadPoolCallableJob();
+	~ThreadPoolCallableJob();
+
+protected:
+	static void _bind_methods();
+
+	void _resolve();
+	void _resize_arguments(const int count);
+	void _clear_arguments();
+
+private:
+	Callable _callable;
+
+	ObjectID _object_id;
+	MethodBind *_method_bind;
+
+	int _argcount;
+	Variant *_args;
+	const Variant **_argptrs;
+
+	Variant _inline_args[INLINE_ARGS];
+	const Variant *_inline_argptrs[INLINE_ARGS];
+};
+
+#endif
+
+#endif
@@ -46,35 +46,61 @@ void ThreadPoolExecuteJob::set_method(const StringName &value) {
 	_method = value;
 }
 
+bool ThreadPoolExecuteJob::get_pooled() const {
+	return _pooled;
+}
+void ThreadPoolExecuteJob::set_pooled(const bool value) {
+	_pooled = value;
+}
+
 void ThreadPoolExecuteJob::_execute() {
 	ERR_FAIL_COND(!_object);
 	ERR_FAIL_COND(!_object->has_method(_method));
 
 #if VERSION_MAJOR < 4
 	Variant::CallError error;
+
+	set_result(_object->call(_method, _argptrs, _argcount, error));
 #else
 	Callable::CallError error;
+
+	set_result(_object->callp(_method, _argptrs, _argcount, error));
 #endif
 
-	_object->call(_method, const_cast<const Variant **>(&_argptr), _argcount, error);
+	//Otherwise it would be run again in the next frame, when threads are not used
+	set_complete(true);
+
+	//Pooled jobs can stay in the pool for a long time, don't keep the arguments alive
+	if (_pooled) {
+		_clear_arguments();
+	}
+}
+
+void ThreadPoolExecuteJob::reset() {
+	ThreadPoolJob::reset();
+
+	_clear_arguments();
 }
 
 void ThreadPoolExecuteJob::_setup(const Variant &obj, const StringName &p_method, const Variant **p_arg, int p_argcount) {
 	set_complete(false);
 	set_cancelled(false);
+	set_result(Variant());
 	_object = obj;
 	_method = p_method;
 
-	for (int i = 0; i < 5; ++i) {
+	for (int i = 0; i < MAX_ARGS; ++i) {
 		if (i < p_argcount) {
-			_argptr[i] = *p_arg[i];
+			_args[i] = *p_arg[i];
 		} else {
-			_argptr[i] = Variant();
+			_args[i] = Variant();
 		}
 	}
 
-	for (int i = 4; i >= 0; --i) {
-		if (_argptr[i].get_type() != Variant::NIL) {
+	_argcount = 0;
+
+	for (int i = MAX_ARGS - 1; i >= 0; --i) {
+		if (_args[i].get_type() != Variant::NIL) {
 			_argcount = i + 1;
 			break;
 		}
@@ -104,6 +130,17 @@ Variant ThreadPoolExecuteJob::_setup_bind(const Variant **p_args, int p_argcount
 		return Variant();
 	}
 
+	if (p_argcount > MAX_ARGS + 2) {
+#if VERSION_MAJOR < 4
+		r_error.error = Variant::CallError::CALL_ERROR_TOO_MANY_ARGUMENTS;
+#else
+		r_error.error = Callable::CallError::CALL_ERROR_TOO_MANY_ARGUMENTS;
+#endif
+
+		r_error.argument = MAX_ARGS + 2;
+		return Variant();
+	}
+
 	if (p_args[0]->get_type() != Variant::OBJECT) {
 #if VERSION_MAJOR < 4
 		r_error.error = Variant::CallError::CALL_ERROR_INVALID_ARGUMENT;
@@ -129,34 +166,20 @@ Variant ThreadPoolExecuteJob::_setup_bind(const Variant **p_args, int p_argcount
 	}
 
 	set_complete(false);
+	set_result(Variant());
 	_object = *p_args[0];
 
 	StringName sn = *p_args[1];
 	_method = sn;
 
-	if (p_argcount > 2) {
-		_argcount = 1;
-		_argptr[0] = *p_args[2];
-	}
+	_argcount = p_argcount - 2;
 
-	if (p_argcount > 3) {
-		_argcount = 2;
-		_argptr[1] = *p_args[3];
-	}
-
-	if (p_argcount > 4) {
-		_argcount = 3;
-		_argptr[2] = *p_args[4];
-	}
-
-	if (p_argcount > 5) {
-		_argcount = 4;
-		_argptr[3] = *p_args[5];
-	}
-
-	if (p_argcount > 6) {
-		_argcount = 5;
-		_argptr[4] = *p_args[6];
+	for (int i = 0; i < MAX_ARGS; ++i) {
+		if (i < _argcount) {
+			_args[i] = *p_args[i + 2];
+		} else {
+			_args[i] = Variant();
+		}
 	}
 
 	if (!_object || !_object->has_method(_method)) {
@@ -172,15 +195,28 @@ Variant ThreadPoolExecuteJob::_setup_bind(const Variant **p_args, int p_argcount
 	return Variant();
 }
 
+void ThreadPoolExecuteJob::_clear_arguments() {
+	_object = NULL;
+	_method = StringName();
+	_argcount = 0;
+
+	for (int i = 0; i < MAX_ARGS; ++i) {
+		_args[i] = Variant();
+	}
+}
+
 ThreadPoolExecuteJob::ThreadPoolExecuteJob() {
 	_object = NULL;
 
 	_argcount = 0;
 
-	_argptr = memnew_arr(Variant, 5);
+	for (int i = 0; i < MAX_ARGS; ++i) {
+		_argptrs[i] = &_args[i];
+	}
+
+	_pooled = false;
 }
 ThreadPoolExecuteJob::~ThreadPoolExecuteJob() {
-	memdelete_arr(_argptr);
 }
 
 void ThreadPoolExecuteJob::_bind_methods() {
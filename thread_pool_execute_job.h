@@ -29,13 +29,21 @@ class ThreadPoolExecuteJob : public ThreadPoolJob {
 	GDCLASS(ThreadPoolExecuteJob, ThreadPoolJob);
 
 public:
+	enum {
+		MAX_ARGS = 5,
+	};
+
 	Variant get_object() const;
 	void set_object(const Variant &value);
 
 	StringName get_method() const;
 	void set_method(const StringName &value);
 
+	bool get_pooled() const;
+	void set_pooled(const bool value);
+
 	void _execute();
+	void reset();
 
 	template <typename... VarArgs>
 	void setup(int p_peer_id, const StringName &p_method, VarArgs... p_args) {
@@ -60,11 +68,15 @@ public:
 protected:
 	static void _bind_methods();
 
+	void _clear_arguments();
+
 private:
 	Object *_object;
 	StringName _method;
 	int _argcount;
-	Variant *_argptr;
+	Variant _args[MAX_ARGS];
+	const Variant *_argptrs[MAX_ARGS];
+	bool _pooled;
 };
 
 #endif
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_future.h"
+
+bool ThreadPoolFuture::is_resolved() const {
+	return _resolved;
+}
+bool ThreadPoolFuture::is_cancelled() const {
+	return _cancelled;
+}
+
+Variant ThreadPoolFuture::get_result() const {
+	return _result;
+}
+
+void ThreadPoolFuture::resolve(const Variant &result, const bool cancelled) {
+	ERR_FAIL_COND(_resolved);
+
+	_result = result;
+	_cancelled = cancelled;
+	_resolved = true;
+
+	emit_signal("completed", _result);
+}
+
+ThreadPoolFuture::ThreadPoolFuture() {
+	_resolved = false;
+	_cancelled = false;
+}
+
+ThreadPoolFuture::~ThreadPoolFuture() {
+}
+
+void ThreadPoolFuture::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("is_resolved"), &ThreadPoolFuture::is_resolved);
+	ClassDB::bind_method(D_METHOD("is_cancelled"), &ThreadPoolFuture::is_cancelled);
+
+	ClassDB::bind_method(D_METHOD("get_result"), &ThreadPoolFuture::get_result);
+
+	ADD_SIGNAL(MethodInfo("completed", PropertyInfo(Variant::NIL, "result", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NIL_IS_VARIANT)));
+}
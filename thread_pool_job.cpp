@@ -32,6 +32,8 @@ SOFTWARE.
 
 #include "core/os/os.h"
 
+#include "thread_pool.h"
+
 bool ThreadPoolJob::get_complete() const {
 	return _complete;
 }
@@ -40,7 +42,7 @@ void ThreadPoolJob::set_complete(const bool value) {
 }
 
 bool ThreadPoolJob::get_cancelled() const {
-	return _cancelled;
+	return _cancelled || (_group.is_valid() && _group->is_cancelled());
 }
 void ThreadPoolJob::set_cancelled(const bool value) {
 	_cancelled = value;
@@ -79,6 +81,149 @@ void ThreadPoolJob::reset_stages() {
 	_stage = 0;
 }
 
+float ThreadPoolJob::get_deadline() const {
+	return _deadline;
+}
+void ThreadPoolJob::set_deadline(const float value) {
+	_deadline = value;
+}
+
+uint64_t ThreadPoolJob::get_deadline_usec() const {
+	return _deadline_usec;
+}
+void ThreadPoolJob::set_deadline_usec(const uint64_t value) {
+	_deadline_usec = value;
+}
+
+int ThreadPoolJob::get_priority() const {
+	return _priority;
+}
+void ThreadPoolJob::set_priority(const int value) {
+	_priority = value;
+}
+
+StringName ThreadPoolJob::get_affinity_key() const {
+	return _affinity_key;
+}
+void ThreadPoolJob::set_affinity_key(const StringName &value) {
+	_affinity_key = value;
+}
+
+StringName ThreadPoolJob::get_coalesce_key() const {
+	return _coalesce_key;
+}
+void ThreadPoolJob::set_coalesce_key(const StringName &value) {
+	//The pool indexes queued jobs by their key
+	ERR_FAIL_COND_MSG(is_queued(), "ThreadPoolJob: The coalesce_key can't be changed while the job is queued!");
+
+	_coalesce_key = value;
+}
+
+bool ThreadPoolJob::get_micro() const {
+	return _micro;
+}
+void ThreadPoolJob::set_micro(const bool value) {
+	_micro = value;
+}
+
+StringName ThreadPoolJob::get_category() const {
+	return _category;
+}
+void ThreadPoolJob::set_category(const StringName &value) {
+	_category = value;
+}
+
+Ref<ThreadPoolJobGroup> ThreadPoolJob::get_group() const {
+	return _group;
+}
+void ThreadPoolJob::set_group(const Ref<ThreadPoolJobGroup> &value) {
+	_group = value;
+}
+
+Variant ThreadPoolJob::get_result() const {
+	return _result;
+}
+void ThreadPoolJob::set_result(const Variant &value) {
+	_result = value;
+}
+
+Ref<ThreadPoolFuture> ThreadPoolJob::get_future() const {
+	return _future;
+}
+void ThreadPoolJob::set_future(const Ref<ThreadPoolFuture> &value) {
+	_future = value;
+}
+
+Ref<ThreadPoolArrayView> ThreadPoolJob::get_array_view() const {
+	return _array_view;
+}
+void ThreadPoolJob::set_array_view(const Ref<ThreadPoolArrayView> &value) {
+	_array_view = value;
+}
+
+void ThreadPoolJob::spawn(const Ref<ThreadPoolJob> &child) {
+	ThreadPool::get_singleton()->spawn_job(this, child);
+}
+
+void ThreadPoolJob::sync() {
+	ThreadPool::get_singleton()->sync_jobs(this);
+}
+
+int ThreadPoolJob::get_pending_children_count() const {
+	return _pending_children.get();
+}
+
+bool ThreadPoolJob::get_in_mailbox() const {
+	return _in_mailbox.is_set();
+}
+void ThreadPoolJob::set_in_mailbox(const bool value) {
+	_in_mailbox.set_to(value);
+}
+
+void ThreadPoolJob::requeue(const float delay) {
+	ERR_FAIL_COND_MSG(delay < 0, "ThreadPoolJob: The requeue delay can't be negative!");
+
+	_requeue_delay = delay;
+}
+float ThreadPoolJob::get_requeue_delay() const {
+	return _requeue_delay;
+}
+void ThreadPoolJob::clear_requeue() {
+	_requeue_delay = -1;
+}
+
+bool ThreadPoolJob::get_requeued() const {
+	return _requeued.is_set();
+}
+void ThreadPoolJob::set_requeued(const bool value) {
+	_requeued.set_to(value);
+}
+
+ThreadPoolJob *ThreadPoolJob::get_spawn_parent() const {
+	return _spawn_parent;
+}
+void ThreadPoolJob::set_spawn_parent(ThreadPoolJob *value) {
+	_spawn_parent = value;
+}
+
+void ThreadPoolJob::_child_spawned() {
+	_pending_children.increment();
+}
+
+void ThreadPoolJob::_child_finished() {
+	_pending_children.decrement();
+}
+
+bool ThreadPoolJob::is_queued() const {
+	return _queue_owner != NULL || _in_mailbox.is_set() || _requeued.is_set();
+}
+ThreadPoolJob *ThreadPoolJob::get_queue_prev() const {
+	return _queue_prev;
+}
+ThreadPoolJob *ThreadPoolJob::get_queue_next() const {
+	return _queue_next;
+}
+
 Variant ThreadPoolJob::get_object() const {
 	return _object;
 }
@@ -117,7 +262,8 @@ bool ThreadPoolJob::should_do(const bool just_check) {
 	return true;
 }
 bool ThreadPoolJob::should_return() {
-	if (_cancelled)
+	//Also true when the job's group got cancelled
+	if (get_cancelled())
 		return true;
 
 	if (_max_allocated_time < 0.00001)
@@ -127,8 +273,6 @@ bool ThreadPoolJob::should_return() {
 }
 
 void ThreadPoolJob::execute() {
-	ERR_FAIL_COND(!has_method("_execute"));
-
 	_current_run_stage = 0;
 
 #if VERSION_MAJOR < 4
@@ -137,6 +281,46 @@ void ThreadPoolJob::execute() {
 	_start_time = OS::get_singleton()->get_ticks_msec();
 #endif
 
+	_execute();
+
+	//Children can't outlive their parent
+	if (_pending_children.get() > 0) {
+		sync();
+	}
+}
+
+void ThreadPoolJob::reset() {
+	_complete = true;
+	_cancelled = false;
+
+	_max_allocated_time = 0;
+	_start_time = 0;
+
+	_current_run_stage = 0;
+	_stage = 0;
+
+	_deadline = 0;
+	_deadline_usec = 0;
+
+	_priority = 0;
+	_category = StringName();
+	_affinity_key = StringName();
+	_coalesce_key = StringName();
+	_micro = false;
+	_requeue_delay = -1;
+
+	_group.unref();
+	_future.unref();
+	_result = Variant();
+	_array_view.unref();
+
+	_object = NULL;
+	_method = StringName();
+}
+
+void ThreadPoolJob::_execute() {
+	ERR_FAIL_COND(!has_method("_execute"));
+
 #if VERSION_MAJOR < 4
 	call("_execute");
 #else
@@ -154,14 +338,25 @@ ThreadPoolJob::ThreadPoolJob() {
 	_current_run_stage = 0;
 	_stage = 0;
 
+	_deadline = 0;
+	_deadline_usec = 0;
+
+	_priority = 0;
+	_category = StringName();
+	_affinity_key = StringName();
+	_coalesce_key = StringName();
+	_micro = false;
+	_requeue_delay = -1;
+
 	_object = NULL;
 
-	_argcount = 0;
+	_queue_owner = NULL;
+	_queue_prev = NULL;
+	_queue_next = NULL;
 
-	_argptr = memnew_arr(Variant, 5);
+	_spawn_parent = NULL;
 }
 ThreadPoolJob::~ThreadPoolJob() {
-	memdelete_arr(_argptr);
 }
 
 void ThreadPoolJob::_bind_methods() {
@@ -195,6 +390,67 @@ void ThreadPoolJob::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("reset_stages"), &ThreadPoolJob::reset_stages);
 
+	ClassDB::bind_method(D_METHOD("get_deadline"), &ThreadPoolJob::get_deadline);
+	ClassDB::bind_method(D_METHOD("set_deadline", "value"), &ThreadPoolJob::set_deadline);
+#if VERSION_MAJOR < 4
+	ADD_PROPERTY(PropertyInfo(Variant::REAL, "deadline"), "set_deadline", "get_deadline");
+#else
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "deadline"), "set_deadline", "get_deadline");
+#endif
+
+	ClassDB::bind_method(D_METHOD("get_priority"), &ThreadPoolJob::get_priority);
+	ClassDB::bind_method(D_METHOD("set_priority", "value"), &ThreadPoolJob::set_priority);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "priority"), "set_priority", "get_priority");
+
+	ClassDB::bind_method(D_METHOD("get_category"), &ThreadPoolJob::get_category);
+	ClassDB::bind_method(D_METHOD("set_category", "value"), &ThreadPoolJob::set_category);
+#if VERSION_MAJOR < 4
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "category"), "set_category", "get_category");
+#else
+	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "category"), "set_category", "get_category");
+#endif
+
+	ClassDB::bind_method(D_METHOD("get_affinity_key"), &ThreadPoolJob::get_affinity_key);
+	ClassDB::bind_method(D_METHOD("set_affinity_key", "value"), &ThreadPoolJob::set_affinity_key);
+#if VERSION_MAJOR < 4
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "affinity_key"), "set_affinity_key", "get_affinity_key");
+#else
+	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "affinity_key"), "set_affinity_key", "get_affinity_key");
+#endif
+
+	ClassDB::bind_method(D_METHOD("get_coalesce_key"), &ThreadPoolJob::get_coalesce_key);
+	ClassDB::bind_method(D_METHOD("set_coalesce_key", "value"), &ThreadPoolJob::set_coalesce_key);
+#if VERSION_MAJOR < 4
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "coalesce_key"), "set_coalesce_key", "get_coalesce_key");
+#else
+	ADD_PROPERTY(PropertyInfo(Variant::STRING_NAME, "coalesce_key"), "set_coalesce_key", "get_coalesce_key");
+#endif
+
+	ClassDB::bind_method(D_METHOD("get_micro"), &ThreadPoolJob::get_micro);
+	ClassDB::bind_method(D_METHOD("set_micro", "value"), &ThreadPoolJob::set_micro);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "micro"), "set_micro", "get_micro");
+
+	ClassDB::bind_method(D_METHOD("requeue", "delay"), &ThreadPoolJob::requeue);
+	ClassDB::bind_method(D_METHOD("get_requeued"), &ThreadPoolJob::get_requeued);
+
+	ClassDB::bind_method(D_METHOD("get_group"), &ThreadPoolJob::get_group);
+
+	ClassDB::bind_method(D_METHOD("get_result"), &ThreadPoolJob::get_result);
+	ClassDB::bind_method(D_METHOD("set_result", "value"), &ThreadPoolJob::set_result);
+	ADD_PROPERTY(PropertyInfo(Variant::NIL, "result", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NIL_IS_VARIANT), "set_result", "get_result");
+
+	ClassDB::bind_method(D_METHOD("get_future"), &ThreadPoolJob::get_future);
+
+	ClassDB::bind_method(D_METHOD("get_array_view"), &ThreadPoolJob::get_array_view);
+	ClassDB::bind_method(D_METHOD("set_array_view", "value"), &ThreadPoolJob::set_array_view);
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "array_view"), "set_array_view", "get_array_view");
+
+	ClassDB::bind_method(D_METHOD("spawn", "child"), &ThreadPoolJob::spawn);
+	ClassDB::bind_method(D_METHOD("sync"), &ThreadPoolJob::sync);
+	ClassDB::bind_method(D_METHOD("get_pending_children_count"), &ThreadPoolJob::get_pending_children_count);
+
+	ClassDB::bind_method(D_METHOD("is_queued"), &ThreadPoolJob::is_queued);
+
 	ClassDB::bind_method(D_METHOD("get_current_execution_time"), &ThreadPoolJob::get_current_execution_time);
 
 	ClassDB::bind_method(D_METHOD("should_do", "just_check"), &ThreadPoolJob::should_do, DEFVAL(false));
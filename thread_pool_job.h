@@ -27,6 +27,7 @@ SOFTWARE.
 
 #if VERSION_MAJOR > 3
 #include "core/object/ref_counted.h"
+#include "core/templates/safe_refcount.h"
 #ifndef Reference
 #define Reference RefCounted
 #endif
@@ -34,8 +35,15 @@ SOFTWARE.
 #include "core/object/script_language.h"
 #else
 #include "core/reference.h"
+#include "core/safe_refcount.h"
 #endif
 
+#include "thread_pool_array_view.h"
+#include "thread_pool_future.h"
+#include "thread_pool_job_group.h"
+
+class ThreadPoolJobQueue;
+
 class ThreadPoolJob : public Reference {
 	GDCLASS(ThreadPoolJob, Reference);
 
@@ -63,6 +71,73 @@ public:
 
 	void reset_stages();
 
+	float get_deadline() const;
+	void set_deadline(const float value);
+
+	uint64_t get_deadline_usec() const;
+	void set_deadline_usec(const uint64_t value);
+
+	int get_priority() const;
+	void set_priority(const int value);
+
+	StringName get_category() const;
+	void set_category(const StringName &value);
+
+	// Jobs with the same key prefer running on the same worker, so its cache still holds their data
+	StringName get_affinity_key() const;
+	void set_affinity_key(const StringName &value);
+
+	// Queued jobs with the same key are coalesced by add_job, see ThreadPool::CoalescePolicy
+	StringName get_coalesce_key() const;
+	void set_coalesce_key(const StringName &value);
+
+	// Tiny jobs, that are batched together, and run by one worker in a single dispatch
+	bool get_micro() const;
+	void set_micro(const bool value);
+
+	Ref<ThreadPoolJobGroup> get_group() const;
+	void set_group(const Ref<ThreadPoolJobGroup> &value);
+
+	Variant get_result() const;
+	void set_result(const Variant &value);
+
+	Ref<ThreadPoolFuture> get_future() const;
+	void set_future(const Ref<ThreadPoolFuture> &value);
+
+	Ref<ThreadPoolArrayView> get_array_view() const;
+	void set_array_view(const Ref<ThreadPoolArrayView> &value);
+
+	// Fork-join inside jobs. Children go to the current thread's local queue, idle workers can steal them.
+	// sync() runs the remaining children on the calling thread, instead of blocking.
+	// Jobs sync automatically after _execute.
+	void spawn(const Ref<ThreadPoolJob> &child);
+	void sync();
+	int get_pending_children_count() const;
+
+	// Set by the ThreadPool, while the job waits in a worker's mailbox
+	bool get_in_mailbox() const;
+	void set_in_mailbox(const bool value);
+
+	// Call in _execute, then return without setting complete, if the job waits for something outside of the pool.
+	// The pool runs it again after delay seconds, instead of finishing it, without a worker (or the frame) waiting on it.
+	void requeue(const float delay);
+	float get_requeue_delay() const;
+	void clear_requeue();
+
+	// Set by the ThreadPool, while a requeued job waits to run again
+	bool get_requeued() const;
+	void set_requeued(const bool value);
+
+	ThreadPoolJob *get_spawn_parent() const;
+	void set_spawn_parent(ThreadPoolJob *value);
+	void _child_spawned();
+	void _child_finished();
+
+	// Also true while the job waits in a worker's mailbox, see ThreadPool::add_job_to_worker
+	bool is_queued() const;
+	ThreadPoolJob *get_queue_prev() const;
+	ThreadPoolJob *get_queue_next() const;
+
 	Variant get_object() const;
 	void set_object(const Variant &value);
 
@@ -76,6 +151,12 @@ public:
 
 	void execute();
 
+	// Clears the state of the job, so it can be reused
+	virtual void reset();
+
+	// C++ jobs can override this, by default it calls the script's _execute
+	virtual void _execute();
+
 #if VERSION_MAJOR >= 4
 	GDVIRTUAL0(_execute);
 #endif
@@ -84,6 +165,8 @@ public:
 	~ThreadPoolJob();
 
 protected:
+	friend class ThreadPoolJobQueue;
+
 	static void _bind_methods();
 
 private:
@@ -96,10 +179,36 @@ private:
 	int _current_run_stage;
 	int _stage;
 
+	float _deadline;
+	uint64_t _deadline_usec;
+
+	int _priority;
+	StringName _category;
+	StringName _affinity_key;
+	StringName _coalesce_key;
+	bool _micro;
+
+	Ref<ThreadPoolJobGroup> _group;
+
+	Variant _result;
+	Ref<ThreadPoolFuture> _future;
+
 	Object *_object;
 	StringName _method;
-	int _argcount;
-	Variant *_argptr;
+
+	Ref<ThreadPoolArrayView> _array_view;
+
+	SafeNumeric<uint32_t> _pending_children;
+	ThreadPoolJob *_spawn_parent;
+
+	SafeFlag _in_mailbox;
+
+	float _requeue_delay;
+	SafeFlag _requeued;
+
+	ThreadPoolJobQueue *_queue_owner;
+	ThreadPoolJob *_queue_prev;
+	ThreadPoolJob *_queue_next;
 };
 
 #endif
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_job_group.h"
+
+#include "core/os/os.h"
+
+#include "thread_pool.h"
+#include "thread_pool_job.h"
+
+int ThreadPoolJobGroup::get_pending_count() const {
+	return _pending.get();
+}
+
+bool ThreadPoolJobGroup::is_done() const {
+	return _pending.get() == 0;
+}
+bool ThreadPoolJobGroup::is_cancelled() const {
+	return _cancelled.is_set();
+}
+
+void ThreadPoolJobGroup::add_job(const Ref<ThreadPoolJob> &job) {
+	ERR_FAIL_COND(!job.is_valid());
+	ERR_FAIL_COND_MSG(job->get_group().is_valid(), "ThreadPoolJobGroup: The job is already in a group!");
+
+	ThreadPool *pool = ThreadPool::get_singleton();
+
+	//Has to be set up before the pool sees the job, as a worker might finish it right away
+	_pending.increment();
+
+	job->set_group(Ref<ThreadPoolJobGroup>(this));
+
+	if (pool->add_job_with_policy(job, pool->get_queue_full_policy())) {
+		return;
+	}
+
+	//A job dropped because of a full queue was already finished as cancelled, that cleared the group
+	if (job->get_group().ptr() == this) {
+		job->set_group(Ref<ThreadPoolJobGroup>());
+		_job_finished();
+	}
+}
+
+void ThreadPoolJobGroup::wait() {
+	ThreadPool *pool = ThreadPool::get_singleton();
+
+	while (!is_done()) {
+		//Help out instead of just blocking, like ThreadPoolJob::sync()
+		if (pool->help_run_job()) {
+			continue;
+		}
+
+		OS::get_singleton()->delay_usec(100);
+	}
+}
+
+void ThreadPoolJobGroup::cancel() {
+	//Jobs check this in get_cancelled(), so queued jobs will just get skipped
+	_cancelled.set();
+}
+
+void ThreadPoolJobGroup::_job_finished() {
+	if (_pending.decrement() == 0) {
+		call_deferred("emit_signal", "completed");
+	}
+}
+
+ThreadPoolJobGroup::ThreadPoolJobGroup() {
+}
+
+ThreadPoolJobGroup::~ThreadPoolJobGroup() {
+}
+
+void ThreadPoolJobGroup::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_pending_count"), &ThreadPoolJobGroup::get_pending_count);
+
+	ClassDB::bind_method(D_METHOD("is_done"), &ThreadPoolJobGroup::is_done);
+	ClassDB::bind_method(D_METHOD("is_cancelled"), &ThreadPoolJobGroup::is_cancelled);
+
+	ClassDB::bind_method(D_METHOD("add_job", "job"), &ThreadPoolJobGroup::add_job);
+
+	ClassDB::bind_method(D_METHOD("wait"), &ThreadPoolJobGroup::wait);
+	ClassDB::bind_method(D_METHOD("cancel"), &ThreadPoolJobGroup::cancel);
+
+	ADD_SIGNAL(MethodInfo("completed"));
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_JOB_GROUP_H
+#define THREAD_POOL_JOB_GROUP_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/object/ref_counted.h"
+#ifndef Reference
+#define Reference RefCounted
+#endif
+#include "core/templates/safe_refcount.h"
+#else
+#include "core/reference.h"
+#include "core/safe_refcount.h"
+#endif
+
+class ThreadPoolJob;
+
+// Lets you wait for, or cancel a set of jobs at once.
+// Jobs only keep a counter updated, so it doesn't matter how many jobs the group has.
+class ThreadPoolJobGroup : public Reference {
+	GDCLASS(ThreadPoolJobGroup, Reference);
+
+public:
+	int get_pending_count() const;
+
+	bool is_done() const;
+	bool is_cancelled() const;
+
+	void add_job(const Ref<ThreadPoolJob> &job);
+
+	void wait();
+	void cancel();
+
+	void _job_finished();
+
+	ThreadPoolJobGroup();
+	~ThreadPoolJobGroup();
+
+protected:
+	static void _bind_methods();
+
+private:
+	SafeNumeric<uint32_t> _pending;
+	SafeFlag _cancelled;
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_job_queue.h"
+
+int ThreadPoolJobQueue::size() const {
+	return _size;
+}
+bool ThreadPoolJobQueue::empty() const {
+	return _size == 0;
+}
+
+ThreadPoolJob *ThreadPoolJobQueue::front() const {
+	return _front;
+}
+ThreadPoolJob *ThreadPoolJobQueue::back() const {
+	return _back;
+}
+
+bool ThreadPoolJobQueue::has(const ThreadPoolJob *job) const {
+	return job && job->_queue_owner == this;
+}
+
+bool ThreadPoolJobQueue::push_back(ThreadPoolJob *job) {
+	ERR_FAIL_COND_V(!job, false);
+	ERR_FAIL_COND_V_MSG(job->_queue_owner, false, "ThreadPoolJobQueue: The job is already queued!");
+
+	_link(_back, job);
+
+	return true;
+}
+
+bool ThreadPoolJobQueue::push_front(ThreadPoolJob *job) {
+	ERR_FAIL_COND_V(!job, false);
+	ERR_FAIL_COND_V_MSG(job->_queue_owner, false, "ThreadPoolJobQueue: The job is already queued!");
+
+	_link(NULL, job);
+
+	return true;
+}
+
+bool ThreadPoolJobQueue::insert_after(ThreadPoolJob *after, ThreadPoolJob *job) {
+	ERR_FAIL_COND_V(!job, false);
+	ERR_FAIL_COND_V(after && after->_queue_owner != this, false);
+	ERR_FAIL_COND_V_MSG(job->_queue_owner, false, "ThreadPoolJobQueue: The job is already queued!");
+
+	_link(after, job);
+
+	return true;
+}
+
+Ref<ThreadPoolJob> ThreadPoolJobQueue::pop_front() {
+	ThreadPoolJob *job = take_front();
+
+	if (!job) {
+		return Ref<ThreadPoolJob>();
+	}
+
+	//The returned Ref takes over from the reference the queue held
+	Ref<ThreadPoolJob> ret = Ref<ThreadPoolJob>(job);
+	job->unreference();
+
+	return ret;
+}
+
+ThreadPoolJob *ThreadPoolJobQueue::take_front() {
+	return take(_front);
+}
+
+ThreadPoolJob *ThreadPoolJobQueue::take(ThreadPoolJob *job) {
+	if (!has(job)) {
+		return NULL;
+	}
+
+	_unlink(job);
+
+	return job;
+}
+
+bool ThreadPoolJobQueue::erase(ThreadPoolJob *job) {
+	if (!has(job)) {
+		return false;
+	}
+
+	_unlink(job);
+
+	if (job->unreference()) {
+		memdelete(job);
+	}
+
+	return true;
+}
+
+void ThreadPoolJobQueue::clear() {
+	while (_front) {
+		erase(_front);
+	}
+}
+
+void ThreadPoolJobQueue::_link(ThreadPoolJob *prev, ThreadPoolJob *job) {
+	job->reference();
+
+	job->_queue_owner = this;
+	job->_queue_prev = prev;
+
+	if (prev) {
+		job->_queue_next = prev->_queue_next;
+		prev->_queue_next = job;
+	} else {
+		job->_queue_next = _front;
+		_front = job;
+	}
+
+	if (job->_queue_next) {
+		job->_queue_next->_queue_prev = job;
+	} else {
+		_back = job;
+	}
+
+	++_size;
+}
+
+void ThreadPoolJobQueue::_unlink(ThreadPoolJob *job) {
+	if (job->_queue_prev) {
+		job->_queue_prev->_queue_next = job->_queue_next;
+	} else {
+		_front = job->_queue_next;
+	}
+
+	if (job->_queue_next) {
+		job->_queue_next->_queue_prev = job->_queue_prev;
+	} else {
+		_back = job->_queue_prev;
+	}
+
+	job->_queue_owner = NULL;
+	job->_queue_prev = NULL;
+	job->_queue_next = NULL;
+
+	--_size;
+}
+
+ThreadPoolJobQueue::ThreadPoolJobQueue() {
+	_front = NULL;
+	_back = NULL;
+	_size = 0;
+}
+
+ThreadPoolJobQueue::~ThreadPoolJobQueue() {
+	clear();
+}
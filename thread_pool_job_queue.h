@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_JOB_QUEUE_H
+#define THREAD_POOL_JOB_QUEUE_H
+
+#include "thread_pool_job.h"
+
+// Intrusive doubly linked list of jobs, the links are stored in the jobs themselves,
+// so pushing and popping doesn't allocate. A job can only be in one queue at a time.
+// The queue holds a reference to every job in it. Not thread safe, the owner has to lock.
+class ThreadPoolJobQueue {
+public:
+	int size() const;
+	bool empty() const;
+
+	ThreadPoolJob *front() const;
+	ThreadPoolJob *back() const;
+
+	bool has(const ThreadPoolJob *job) const;
+
+	// These fail and return false, if the job is already in a queue
+	bool push_back(ThreadPoolJob *job);
+	bool push_front(ThreadPoolJob *job);
+	bool insert_after(ThreadPoolJob *after, ThreadPoolJob *job);
+
+	Ref<ThreadPoolJob> pop_front();
+	// Same as pop_front, but the queue's reference is handed over to the caller
+	ThreadPoolJob *take_front();
+	// Removes the job from anywhere in the queue, and hands the queue's reference over to the caller. Returns NULL if it's not in this queue
+	ThreadPoolJob *take(ThreadPoolJob *job);
+	bool erase(ThreadPoolJob *job);
+
+	void clear();
+
+	ThreadPoolJobQueue();
+	~ThreadPoolJobQueue();
+
+protected:
+	void _link(ThreadPoolJob *prev, ThreadPoolJob *job);
+	void _unlink(ThreadPoolJob *job);
+
+private:
+	ThreadPoolJob *_front;
+	ThreadPoolJob *_back;
+	int _size;
+};
+
+#endif
@@ -0,0 +1,291 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_PARALLEL_H
+#define THREAD_POOL_PARALLEL_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/templates/sort_array.h"
+#include "core/templates/vector.h"
+#else
+#include "core/sort_array.h"
+#include "core/vector.h"
+#endif
+
+#include "thread_pool.h"
+
+// Parallel algorithms built on ThreadPool::submit.
+// Work is split into chunks that fit into the cache, the calling thread processes the first chunk,
+// and helps out with the rest while waiting, so these can be called from jobs too.
+// Callbacks get index ranges, so their inner loops stay simple enough to be vectorized.
+class ThreadPoolParallel {
+public:
+	enum {
+		//About half of a typical L2 cache
+		CHUNK_BYTES = 128 * 1024,
+		MIN_CHUNK_ITEMS = 1024,
+	};
+
+	// Returns how many items should be processed by one task
+	static int get_chunk_size(const int count, const int item_size) {
+		int chunk = MAX(CHUNK_BYTES / MAX(item_size, 1), static_cast<int>(MIN_CHUNK_ITEMS));
+
+		ThreadPool *pool = ThreadPool::get_singleton();
+
+		if (pool && pool->get_use_threads()) {
+			//Use smaller chunks, if otherwise some of the workers would have nothing to do
+			int per_worker = (count + pool->get_thread_count()) / (pool->get_thread_count() + 1);
+			chunk = MIN(chunk, MAX(per_worker, static_cast<int>(MIN_CHUNK_ITEMS)));
+		}
+
+		return chunk;
+	}
+
+	// Calls f(from, to) for every chunk of [0, count)
+	template <class F>
+	static void parallel_for(const int count, F f, const int chunk_size) {
+		if (count <= 0) {
+			return;
+		}
+
+		ThreadPool *pool = ThreadPool::get_singleton();
+		int chunk = MAX(chunk_size, 1);
+
+		if (!pool || count <= chunk) {
+			f(0, count);
+			return;
+		}
+
+		int chunk_count = (count + chunk - 1) / chunk;
+
+		Vector<ThreadPoolTaskFuture> futures;
+		futures.resize(chunk_count - 1);
+
+		for (int i = 1; i < chunk_count; ++i) {
+			int from = i * chunk;
+			int to = MIN(from + chunk, count);
+
+			//f outlives the tasks, as they are all waited for below
+			futures.write[i - 1] = pool->submit([&f, from, to]() {
+				f(from, to);
+			});
+		}
+
+		f(0, chunk);
+
+		for (int i = 0; i < futures.size(); ++i) {
+			pool->wait_task(futures[i]);
+		}
+	}
+
+	template <class T, class F>
+	static void parallel_for(const int count, F f) {
+		parallel_for(count, f, get_chunk_size(count, sizeof(T)));
+	}
+
+	// out[i] = f(data[i]). data and out can be the same
+	template <class T, class R, class F>
+	static void map(const T *data, R *out, const int count, F f) {
+		parallel_for(
+				count, [data, out, &f](const int from, const int to) {
+					for (int i = from; i < to; ++i) {
+						out[i] = f(data[i]);
+					}
+				},
+				get_chunk_size(count, MAX(sizeof(T), sizeof(R))));
+	}
+
+	// Folds the items using op, which has to be associative. identity is the starting value of every chunk
+	template <class T, class Op>
+	static T reduce(const T *data, const int count, const T &identity, Op op) {
+		int chunk = get_chunk_size(count, sizeof(T));
+
+		if (count <= chunk) {
+			return _reduce_range(data, 0, count, identity, op);
+		}
+
+		int chunk_count = (count + chunk - 1) / chunk;
+
+		Vector<T> partials;
+		partials.resize(chunk_count);
+		T *partials_ptr = partials.ptrw();
+
+		parallel_for(
+				chunk_count, [data, count, chunk, partials_ptr, &identity, &op](const int from, const int to) {
+					for (int c = from; c < to; ++c) {
+						partials_ptr[c] = _reduce_range(data, c * chunk, MIN((c + 1) * chunk, count), identity, op);
+					}
+				},
+				1);
+
+		return _reduce_range(partials_ptr, 0, chunk_count, identity, op);
+	}
+
+	// out[i] = op(data[0], ..., data[i]). op has to be associative. data and out can be the same
+	template <class T, class Op>
+	static void inclusive_scan(const T *data, T *out, const int count, const T &identity, Op op) {
+		int chunk = get_chunk_size(count, sizeof(T));
+
+		if (count <= chunk) {
+			_scan_range(data, out, 0, count, identity, op);
+			return;
+		}
+
+		int chunk_count = (count + chunk - 1) / chunk;
+
+		//Sum of every chunk, then the chunks are scanned again, starting from the sum of the previous ones
+		Vector<T> offsets;
+		offsets.resize(chunk_count);
+		T *offsets_ptr = offsets.ptrw();
+
+		parallel_for(
+				chunk_count, [data, count, chunk, offsets_ptr, &identity, &op](const int from, const int to) {
+					for (int c = from; c < to; ++c) {
+						offsets_ptr[c] = _reduce_range(data, c * chunk, MIN((c + 1) * chunk, count), identity, op);
+					}
+				},
+				1);
+
+		T acc = identity;
+
+		for (int c = 0; c < chunk_count; ++c) {
+			T sum = offsets_ptr[c];
+			offsets_ptr[c] = acc;
+			acc = op(acc, sum);
+		}
+
+		parallel_for(
+				chunk_count, [data, out, count, chunk, offsets_ptr, &op](const int from, const int to) {
+					for (int c = from; c < to; ++c) {
+						_scan_range(data, out, c * chunk, MIN((c + 1) * chunk, count), offsets_ptr[c], op);
+					}
+				},
+				1);
+	}
+
+	// Sorts chunks in parallel, then merges pairs of sorted runs, doubling their length every pass.
+	// The merges are stable, but the chunk sorts aren't.
+	template <class T, class Comparator = _DefaultComparator<T>>
+	static void sort(T *data, const int count, const Comparator &compare = Comparator()) {
+		int chunk = get_chunk_size(count, sizeof(T));
+
+		if (count <= chunk) {
+			_sort_range(data, count, compare);
+			return;
+		}
+
+		parallel_for(
+				count, [data, &compare](const int from, const int to) {
+					_sort_range(data + from, to - from, compare);
+				},
+				chunk);
+
+		T *buffer = memnew_arr(T, count);
+		T *src = data;
+		T *dst = buffer;
+
+		for (int width = chunk; width < count; width *= 2) {
+			int pair_count = (count + 2 * width - 1) / (2 * width);
+
+			parallel_for(
+					pair_count, [src, dst, count, width, &compare](const int from, const int to) {
+						for (int p = from; p < to; ++p) {
+							int begin = p * 2 * width;
+							int middle = MIN(begin + width, count);
+							int end = MIN(begin + 2 * width, count);
+
+							_merge(src, dst, begin, middle, end, compare);
+						}
+					},
+					1);
+
+			SWAP(src, dst);
+		}
+
+		if (src != data) {
+			parallel_for<T>(count, [src, data](const int from, const int to) {
+				for (int i = from; i < to; ++i) {
+					data[i] = src[i];
+				}
+			});
+		}
+
+		memdelete_arr(buffer);
+	}
+
+protected:
+	template <class T, class Op>
+	static T _reduce_range(const T *data, const int from, const int to, const T &identity, const Op &op) {
+		T acc = identity;
+
+		for (int i = from; i < to; ++i) {
+			acc = op(acc, data[i]);
+		}
+
+		return acc;
+	}
+
+	template <class T, class Op>
+	static void _scan_range(const T *data, T *out, const int from, const int to, const T &start, const Op &op) {
+		T acc = start;
+
+		for (int i = from; i < to; ++i) {
+			acc = op(acc, data[i]);
+			out[i] = acc;
+		}
+	}
+
+	template <class T, class Comparator>
+	static void _sort_range(T *data, const int count, const Comparator &compare) {
+		SortArray<T, Comparator> sorter;
+		sorter.compare = compare;
+		sorter.sort(data, count);
+	}
+
+	template <class T, class Comparator>
+	static void _merge(const T *src, T *dst, const int begin, const int middle, const int end, const Comparator &compare) {
+		int l = begin;
+		int r = middle;
+		int i = begin;
+
+		while (l < middle && r < end) {
+			//Only take from the right if it's strictly smaller, to keep the merge stable
+			if (compare(src[r], src[l])) {
+				dst[i++] = src[r++];
+			} else {
+				dst[i++] = src[l++];
+			}
+		}
+
+		while (l < middle) {
+			dst[i++] = src[l++];
+		}
+
+		while (r < end) {
+			dst[i++] = src[r++];
+		}
+	}
+};
+
+#endif
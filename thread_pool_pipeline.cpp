@@ -0,0 +1,309 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_pipeline.h"
+
+#include "core/os/os.h"
+
+#include "thread_pool.h"
+
+int ThreadPoolPipeline::get_max_tokens() const {
+	return _max_tokens;
+}
+void ThreadPoolPipeline::set_max_tokens(const int value) {
+	ERR_FAIL_COND(value < 1);
+
+	_max_tokens = value;
+}
+
+int ThreadPoolPipeline::add_stage(Object *target, const StringName &method, const bool serial) {
+	ERR_FAIL_COND_V(!target, -1);
+	ERR_FAIL_COND_V_MSG(get_in_flight_count() > 0, -1, "ThreadPoolPipeline: Stages can't be changed while items are in flight!");
+
+	PipelineStage *stage = memnew(PipelineStage);
+	stage->target = target->get_instance_id();
+	stage->method = method;
+	stage->serial = serial;
+
+	_stages.push_back(stage);
+
+	return _stages.size() - 1;
+}
+
+int ThreadPoolPipeline::get_stage_count() const {
+	return _stages.size();
+}
+
+void ThreadPoolPipeline::clear_stages() {
+	ERR_FAIL_COND_MSG(get_in_flight_count() > 0, "ThreadPoolPipeline: Stages can't be changed while items are in flight!");
+
+	for (int i = 0; i < _stages.size(); ++i) {
+		memdelete(_stages[i]);
+	}
+
+	_stages.clear();
+}
+
+bool ThreadPoolPipeline::push(const Variant &item) {
+	ERR_FAIL_COND_V_MSG(_stages.size() == 0, false, "ThreadPoolPipeline: The pipeline has no stages!");
+
+	_lock.lock();
+
+	if (_in_flight >= _max_tokens) {
+		_lock.unlock();
+		return false;
+	}
+
+	++_in_flight;
+	uint64_t sequence = _next_sequence++;
+
+	_lock.unlock();
+
+	_item_ready(0, sequence, item, false);
+
+	return true;
+}
+
+bool ThreadPoolPipeline::can_push() const {
+	return get_in_flight_count() < _max_tokens;
+}
+
+bool ThreadPoolPipeline::has_output() const {
+	_lock.lock();
+	bool has = !_output.empty();
+	_lock.unlock();
+
+	return has;
+}
+
+Variant ThreadPoolPipeline::pop() {
+	_lock.lock();
+
+	if (_output.empty()) {
+		_lock.unlock();
+		return Variant();
+	}
+
+	Variant item = _output.front()->get();
+	_output.pop_front();
+
+	//Frees up a token
+	--_in_flight;
+
+	_lock.unlock();
+
+	return item;
+}
+
+int ThreadPoolPipeline::get_in_flight_count() const {
+	_lock.lock();
+	int count = _in_flight;
+	_lock.unlock();
+
+	return count;
+}
+
+bool ThreadPoolPipeline::is_done() const {
+	_lock.lock();
+	bool done = _in_flight == _output.size();
+	_lock.unlock();
+
+	return done;
+}
+
+void ThreadPoolPipeline::wait() {
+	ThreadPool *pool = ThreadPool::get_singleton();
+
+	while (!is_done()) {
+		//Help out instead of just blocking, like ThreadPoolJobGroup::wait()
+		if (pool->help_run_job()) {
+			continue;
+		}
+
+		OS::get_singleton()->delay_usec(100);
+	}
+}
+
+void ThreadPoolPipeline::_item_ready(const int stage_index, const uint64_t sequence, const Variant &item, const bool dropped) {
+	if (stage_index == _stages.size()) {
+		_lock.lock();
+
+		bool was_empty = _output.empty();
+
+		if (dropped) {
+			--_in_flight;
+		} else {
+			_output.push_back(item);
+		}
+
+		_lock.unlock();
+
+		if (!dropped && was_empty) {
+			call_deferred("emit_signal", "output_available");
+		}
+
+		return;
+	}
+
+	PipelineStage *stage = _stages[stage_index];
+
+	if (!stage->serial) {
+		_submit(stage_index, sequence, item, dropped);
+		return;
+	}
+
+	//Serial stages buffer the items that arrive out of order, and only ever run one task
+	_lock.lock();
+
+	WaitingItem &waiting = stage->waiting[sequence];
+	waiting.item = item;
+	waiting.dropped = dropped;
+
+	bool start = !stage->running && stage->waiting.has(stage->next_sequence);
+
+	if (start) {
+		stage->running = true;
+	}
+
+	_lock.unlock();
+
+	if (start) {
+		_submit(stage_index, sequence, Variant(), false);
+	}
+}
+
+void ThreadPoolPipeline::_submit(const int stage_index, const uint64_t sequence, const Variant &item, const bool dropped) {
+	Ref<ThreadPoolPipeline> pipeline(this);
+
+	if (_stages[stage_index]->serial) {
+		ThreadPool::get_singleton()->submit([pipeline, stage_index]() {
+			pipeline->_run_serial(stage_index);
+		});
+
+		return;
+	}
+
+	//Small enough to be stored inline in the task
+	ThreadPool::get_singleton()->submit([pipeline, item, sequence, stage_index, dropped]() {
+		pipeline->_run(stage_index, sequence, item, dropped);
+	});
+}
+
+void ThreadPoolPipeline::_run(const int stage_index, const uint64_t sequence, Variant item, bool dropped) {
+	if (!dropped) {
+		dropped = !_process(stage_index, item);
+	}
+
+	//Parallel stages don't care about the order, but the sequence is passed on, so the next serial stage can restore it
+	_item_ready(stage_index + 1, sequence, item, dropped);
+}
+
+void ThreadPoolPipeline::_run_serial(const int stage_index) {
+	PipelineStage *stage = _stages[stage_index];
+
+	//Keeps going while the next item in order is available, instead of submitting a task for each
+	while (true) {
+		_lock.lock();
+
+		const WaitingItem *next = stage->waiting.getptr(stage->next_sequence);
+
+		if (!next) {
+			stage->running = false;
+			_lock.unlock();
+			return;
+		}
+
+		uint64_t sequence = stage->next_sequence++;
+		WaitingItem waiting = *next;
+		stage->waiting.erase(sequence);
+
+		_lock.unlock();
+
+		if (!waiting.dropped) {
+			waiting.dropped = !_process(stage_index, waiting.item);
+		}
+
+		_item_ready(stage_index + 1, sequence, waiting.item, waiting.dropped);
+	}
+}
+
+bool ThreadPoolPipeline::_process(const int stage_index, Variant &item) {
+	PipelineStage *stage = _stages[stage_index];
+
+	Object *target = ObjectDB::get_instance(stage->target);
+
+	if (!target) {
+		item = Variant();
+		return false;
+	}
+
+	const Variant *args[1] = { &item };
+
+#if VERSION_MAJOR < 4
+	Variant::CallError error;
+
+	item = target->call(stage->method, args, 1, error);
+#else
+	Callable::CallError error;
+
+	item = target->callp(stage->method, args, 1, error);
+#endif
+
+	return item.get_type() != Variant::NIL;
+}
+
+ThreadPoolPipeline::ThreadPoolPipeline() {
+	_max_tokens = 16;
+	_in_flight = 0;
+	_next_sequence = 0;
+}
+
+ThreadPoolPipeline::~ThreadPoolPipeline() {
+	for (int i = 0; i < _stages.size(); ++i) {
+		memdelete(_stages[i]);
+	}
+
+	_stages.clear();
+}
+
+void ThreadPoolPipeline::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_max_tokens"), &ThreadPoolPipeline::get_max_tokens);
+	ClassDB::bind_method(D_METHOD("set_max_tokens", "value"), &ThreadPoolPipeline::set_max_tokens);
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "max_tokens"), "set_max_tokens", "get_max_tokens");
+
+	ClassDB::bind_method(D_METHOD("add_stage", "target", "method", "serial"), &ThreadPoolPipeline::add_stage, DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("get_stage_count"), &ThreadPoolPipeline::get_stage_count);
+	ClassDB::bind_method(D_METHOD("clear_stages"), &ThreadPoolPipeline::clear_stages);
+
+	ClassDB::bind_method(D_METHOD("push", "item"), &ThreadPoolPipeline::push);
+	ClassDB::bind_method(D_METHOD("can_push"), &ThreadPoolPipeline::can_push);
+
+	ClassDB::bind_method(D_METHOD("has_output"), &ThreadPoolPipeline::has_output);
+	ClassDB::bind_method(D_METHOD("pop"), &ThreadPoolPipeline::pop);
+
+	ClassDB::bind_method(D_METHOD("get_in_flight_count"), &ThreadPoolPipeline::get_in_flight_count);
+	ClassDB::bind_method(D_METHOD("is_done"), &ThreadPoolPipeline::is_done);
+
+	ClassDB::bind_method(D_METHOD("wait"), &ThreadPoolPipeline::wait);
+
+	ADD_SIGNAL(MethodInfo("output_available"));
+}
@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_PIPELINE_H
+#define THREAD_POOL_PIPELINE_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/list.h"
+#include "core/templates/vector.h"
+#ifndef Reference
+#define Reference RefCounted
+#endif
+#else
+#include "core/hash_map.h"
+#include "core/list.h"
+#include "core/reference.h"
+#include "core/vector.h"
+#endif
+
+#include "core/os/mutex.h"
+
+#if VERSION_MAJOR > 3
+#include "core/object/object.h"
+#else
+#include "core/object.h"
+#endif
+
+// Streams items through a list of stages (read -> decompress -> parse -> build) on the ThreadPool.
+// Every stage is a method that gets an item, and returns the item for the next stage (or null to drop it).
+// Parallel stages run as many items at once as they can, serial stages run one item at a time, in push order.
+// At most max_tokens items can be in flight (including finished ones that were not popped yet),
+// so the buffers between the stages can't grow without bounds.
+class ThreadPoolPipeline : public Reference {
+	GDCLASS(ThreadPoolPipeline, Reference);
+
+public:
+	int get_max_tokens() const;
+	void set_max_tokens(const int value);
+
+	int add_stage(Object *target, const StringName &method, const bool serial = false);
+	int get_stage_count() const;
+	void clear_stages();
+
+	// Returns false if max_tokens items are already in flight, try again after popping some results
+	bool push(const Variant &item);
+	bool can_push() const;
+
+	bool has_output() const;
+	Variant pop();
+
+	int get_in_flight_count() const;
+	bool is_done() const;
+
+	// Blocks until every pushed item reached the output (or got dropped)
+	void wait();
+
+	ThreadPoolPipeline();
+	~ThreadPoolPipeline();
+
+protected:
+	struct WaitingItem {
+		Variant item;
+		bool dropped;
+
+		WaitingItem() {
+			dropped = false;
+		}
+	};
+
+	struct PipelineStage {
+		ObjectID target;
+		StringName method;
+		bool serial;
+
+		//Serial stages only
+		bool running;
+		uint64_t next_sequence;
+		HashMap<uint64_t, WaitingItem> waiting;
+
+		PipelineStage() {
+			target = ObjectID();
+			serial = false;
+			running = false;
+			next_sequence = 0;
+		}
+	};
+
+	void _item_ready(const int stage_index, const uint64_t sequence, const Variant &item, const bool dropped);
+	void _submit(const int stage_index, const uint64_t sequence, const Variant &item, const bool dropped);
+	void _run(const int stage_index, const uint64_t sequence, Variant item, bool dropped);
+	void _run_serial(const int stage_index);
+	bool _process(const int stage_index, Variant &item);
+
+	static void _bind_methods();
+
+private:
+	mutable Mutex _lock;
+
+	Vector<PipelineStage *> _stages;
+
+	int _max_tokens;
+	int _in_flight;
+	uint64_t _next_sequence;
+
+	List<Variant> _output;
+};
+
+#endif
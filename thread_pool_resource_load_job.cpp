@@ -0,0 +1,340 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_resource_load_job.h"
+
+#if VERSION_MAJOR > 3
+Mutex ThreadPoolResourceLoadJob::_shared_requests_lock;
+HashMap<String, ThreadPoolResourceLoadJob::SharedLoadRequest> ThreadPoolResourceLoadJob::_shared_requests;
+#endif
+
+String ThreadPoolResourceLoadJob::get_path() const {
+	return _path;
+}
+void ThreadPoolResourceLoadJob::set_path(const String &value) {
+	_path = value;
+
+	//Otherwise it would be skipped, when threads are not used
+	set_complete(false);
+}
+
+String ThreadPoolResourceLoadJob::get_type_hint() const {
+	return _type_hint;
+}
+void ThreadPoolResourceLoadJob::set_type_hint(const String &value) {
+	_type_hint = value;
+}
+
+Object *ThreadPoolResourceLoadJob::get_requester() const {
+	if (!_has_requester) {
+		return NULL;
+	}
+
+	return ObjectDB::get_instance(_requester);
+}
+void ThreadPoolResourceLoadJob::set_requester(Object *value) {
+	_has_requester = value != NULL;
+	_requester = value ? value->get_instance_id() : ObjectID();
+}
+
+float ThreadPoolResourceLoadJob::get_progress() const {
+	return _progress.load();
+}
+
+Ref<Resource> ThreadPoolResourceLoadJob::get_resource() const {
+	return _resource;
+}
+
+void ThreadPoolResourceLoadJob::_execute() {
+	if (_is_requester_gone()) {
+		//Nobody is waiting for it anymore
+		set_cancelled(true);
+	}
+
+	if (get_cancelled()) {
+		_cancel_load();
+		return;
+	}
+
+#if VERSION_MAJOR < 4
+	if (!_loader.is_valid()) {
+		_loader = ResourceLoader::load_interactive(_path, _type_hint);
+
+		if (!_loader.is_valid()) {
+			_finish(Ref<Resource>());
+			ERR_FAIL_MSG("ThreadPoolResourceLoadJob: Couldn't load: " + _path);
+		}
+	}
+
+	while (true) {
+		Error err = _loader->poll();
+
+		if (_loader->get_stage_count() > 0) {
+			_progress.store(static_cast<float>(_loader->get_stage()) / _loader->get_stage_count());
+		}
+
+		if (err == ERR_FILE_EOF) {
+			Ref<Resource> resource = _loader->get_resource();
+			_loader.unref();
+
+			_finish(resource);
+			return;
+		}
+
+		if (err != OK) {
+			_loader.unref();
+
+			_finish(Ref<Resource>());
+			ERR_FAIL_MSG("ThreadPoolResourceLoadJob: Couldn't load: " + _path);
+		}
+
+		//Checked between every poll, so a load on a worker can be interrupted too
+		if (_is_requester_gone()) {
+			set_cancelled(true);
+		}
+
+		if (get_cancelled()) {
+			_cancel_load();
+			return;
+		}
+
+		//Time slicing when threads are not used
+		if (should_return()) {
+			return;
+		}
+	}
+#else
+	if (!_requested) {
+		if (!_acquire_request(_path, _type_hint)) {
+			_finish(Ref<Resource>());
+			ERR_FAIL_MSG("ThreadPoolResourceLoadJob: Couldn't load: " + _path);
+		}
+
+		_requested = true;
+	}
+
+	float progress = 0;
+	Ref<Resource> resource;
+	ResourceLoader::ThreadLoadStatus status = _poll_request(_path, &progress, &resource);
+
+	if (status != ResourceLoader::THREAD_LOAD_IN_PROGRESS) {
+		_release_request(_path);
+		_requested = false;
+
+		if (status == ResourceLoader::THREAD_LOAD_LOADED) {
+			_finish(resource);
+			return;
+		}
+
+		_finish(Ref<Resource>());
+		ERR_FAIL_MSG("ThreadPoolResourceLoadJob: Couldn't load: " + _path);
+	}
+
+	_progress.store(progress);
+
+	//The engine's threads do the loading, waiting for them here would just keep a worker (or the frame) busy.
+	//The pool runs the job again after the interval instead.
+	requeue(REQUEST_POLL_INTERVAL_USEC / 1000000.0);
+#endif
+}
+
+void ThreadPoolResourceLoadJob::reset() {
+	ThreadPoolJob::reset();
+
+	set_category("resource_load");
+
+#if VERSION_MAJOR < 4
+	_loader.unref();
+#else
+	if (_requested) {
+		_release_request(_path);
+		_requested = false;
+	}
+#endif
+
+	_path = String();
+	_type_hint = String();
+	_requester = ObjectID();
+	_has_requester = false;
+	_progress.store(0);
+	_resource.unref();
+}
+
+bool ThreadPoolResourceLoadJob::_is_requester_gone() const {
+	return _has_requester && !ObjectDB::get_instance(_requester);
+}
+
+void ThreadPoolResourceLoadJob::_finish(const Ref<Resource> &resource) {
+	_resource = resource;
+	_progress.store(1);
+
+	set_result(resource);
+	set_complete(true);
+}
+
+void ThreadPoolResourceLoadJob::_cancel_load() {
+#if VERSION_MAJOR < 4
+	_loader.unref();
+#else
+	//The engine keeps the request until it's collected
+	if (_requested) {
+		_release_request(_path);
+		_requested = false;
+	}
+#endif
+
+	set_complete(true);
+}
+
+#if VERSION_MAJOR > 3
+bool ThreadPoolResourceLoadJob::_acquire_request(const String &path, const String &type_hint) {
+	_shared_requests_lock.lock();
+
+	SharedLoadRequest *request = _shared_requests.getptr(path);
+
+	//Also picks up requests that everyone cancelled, but that were not collected yet
+	if (request) {
+		++request->users;
+
+		_shared_requests_lock.unlock();
+		return true;
+	}
+
+	if (ResourceLoader::load_threaded_request(path, type_hint) != OK) {
+		_shared_requests_lock.unlock();
+		return false;
+	}
+
+	SharedLoadRequest new_request;
+	new_request.users = 1;
+
+	_shared_requests[path] = new_request;
+
+	_shared_requests_lock.unlock();
+
+	return true;
+}
+
+ResourceLoader::ThreadLoadStatus ThreadPoolResourceLoadJob::_poll_request(const String &path, float *r_progress, Ref<Resource> *r_resource) {
+	_shared_requests_lock.lock();
+
+	SharedLoadRequest *request = _shared_requests.getptr(path);
+
+	if (!request) {
+		_shared_requests_lock.unlock();
+
+		ERR_FAIL_V(ResourceLoader::THREAD_LOAD_INVALID_RESOURCE);
+	}
+
+	if (!request->done) {
+		request->status = ResourceLoader::load_threaded_get_status(path, r_progress);
+
+		if (request->status != ResourceLoader::THREAD_LOAD_IN_PROGRESS) {
+			//The engine's request is collected once, by the first job that sees it finish, the rest get it from here
+			request->resource = ResourceLoader::load_threaded_get(path);
+			request->done = true;
+		}
+	}
+
+	ResourceLoader::ThreadLoadStatus status = request->status;
+	*r_resource = request->resource;
+
+	_shared_requests_lock.unlock();
+
+	return status;
+}
+
+void ThreadPoolResourceLoadJob::_release_request(const String &path) {
+	_shared_requests_lock.lock();
+
+	SharedLoadRequest *request = _shared_requests.getptr(path);
+
+	//Requests that are still loading are kept, collecting them now would wait for the load to finish.
+	//collect_abandoned_requests() does it later, otherwise the engine would keep the request (and the resource) forever.
+	if (request && --request->users == 0 && request->done) {
+		_shared_requests.erase(path);
+	}
+
+	_shared_requests_lock.unlock();
+}
+
+void ThreadPoolResourceLoadJob::collect_abandoned_requests() {
+	_shared_requests_lock.lock();
+
+	Vector<String> collected;
+
+	for (const KeyValue<String, SharedLoadRequest> &E : _shared_requests) {
+		if (E.value.users > 0) {
+			continue;
+		}
+
+		if (ResourceLoader::load_threaded_get_status(E.key) != ResourceLoader::THREAD_LOAD_IN_PROGRESS) {
+			collected.push_back(E.key);
+		}
+	}
+
+	for (int i = 0; i < collected.size(); ++i) {
+		//Doesn't wait anymore, the load is finished
+		ResourceLoader::load_threaded_get(collected[i]);
+		_shared_requests.erase(collected[i]);
+	}
+
+	_shared_requests_lock.unlock();
+}
+#endif
+
+ThreadPoolResourceLoadJob::ThreadPoolResourceLoadJob() {
+	set_category("resource_load");
+
+	_requester = ObjectID();
+	_has_requester = false;
+	_progress.store(0);
+
+#if VERSION_MAJOR > 3
+	_requested = false;
+#endif
+}
+
+ThreadPoolResourceLoadJob::~ThreadPoolResourceLoadJob() {
+#if VERSION_MAJOR > 3
+	if (_requested) {
+		_release_request(_path);
+	}
+#endif
+}
+
+void ThreadPoolResourceLoadJob::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_path"), &ThreadPoolResourceLoadJob::get_path);
+	ClassDB::bind_method(D_METHOD("set_path", "value"), &ThreadPoolResourceLoadJob::set_path);
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "path"), "set_path", "get_path");
+
+	ClassDB::bind_method(D_METHOD("get_type_hint"), &ThreadPoolResourceLoadJob::get_type_hint);
+	ClassDB::bind_method(D_METHOD("set_type_hint", "value"), &ThreadPoolResourceLoadJob::set_type_hint);
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "type_hint"), "set_type_hint", "get_type_hint");
+
+	ClassDB::bind_method(D_METHOD("get_requester"), &ThreadPoolResourceLoadJob::get_requester);
+	ClassDB::bind_method(D_METHOD("set_requester", "value"), &ThreadPoolResourceLoadJob::set_requester);
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "requester"), "set_requester", "get_requester");
+
+	ClassDB::bind_method(D_METHOD("get_progress"), &ThreadPoolResourceLoadJob::get_progress);
+	ClassDB::bind_method(D_METHOD("get_resource"), &ThreadPoolResourceLoadJob::get_resource);
+}
@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_RESOURCE_LOAD_JOB_H
+#define THREAD_POOL_RESOURCE_LOAD_JOB_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/io/resource.h"
+#include "core/object/object.h"
+#else
+#include "core/object.h"
+#include "core/resource.h"
+#endif
+
+#include "core/io/resource_loader.h"
+#include "core/os/mutex.h"
+
+#if VERSION_MAJOR > 3
+#include "core/templates/hash_map.h"
+#endif
+
+#include <atomic>
+
+#include "thread_pool_job.h"
+
+// Loads a resource through the pool. On 3.x ResourceInteractiveLoader is used, with threads the load finishes in one run,
+// without them it's spread over frames. On 4.x the engine's threaded load requests do the loading, the job polls them,
+// and requeues itself between polls, so neither a worker nor the frame waits for the load.
+// The job cancels itself when its requester is freed, it's checked between polls.
+// Jobs get the "resource_load" category, so the number of concurrent loads can be limited with set_category_limit.
+class ThreadPoolResourceLoadJob : public ThreadPoolJob {
+	GDCLASS(ThreadPoolResourceLoadJob, ThreadPoolJob);
+
+public:
+	String get_path() const;
+	void set_path(const String &value);
+
+	String get_type_hint() const;
+	void set_type_hint(const String &value);
+
+	Object *get_requester() const;
+	void set_requester(Object *value);
+
+	// 0 - 1, can be read from any thread
+	float get_progress() const;
+
+	Ref<Resource> get_resource() const;
+
+	void _execute();
+	void reset();
+
+#if VERSION_MAJOR > 3
+	// Collects threaded load requests that every job cancelled, once the engine finished them. Called by ThreadPool::update().
+	static void collect_abandoned_requests();
+#endif
+
+	ThreadPoolResourceLoadJob();
+	~ThreadPoolResourceLoadJob();
+
+protected:
+	enum {
+		// How often the job checks on a threaded load request on 4.x
+		REQUEST_POLL_INTERVAL_USEC = 1000,
+	};
+
+	static void _bind_methods();
+
+	bool _is_requester_gone() const;
+	void _finish(const Ref<Resource> &resource);
+	void _cancel_load();
+
+#if VERSION_MAJOR > 3
+	// The engine keys threaded load requests by path, so jobs loading the same path share one request.
+	// Requests without users are kept until collect_abandoned_requests() can collect them.
+	struct SharedLoadRequest {
+		int users;
+		bool done;
+		ResourceLoader::ThreadLoadStatus status;
+		Ref<Resource> resource;
+
+		SharedLoadRequest() {
+			users = 0;
+			done = false;
+			status = ResourceLoader::THREAD_LOAD_IN_PROGRESS;
+		}
+	};
+
+	static bool _acquire_request(const String &path, const String &type_hint);
+	static ResourceLoader::ThreadLoadStatus _poll_request(const String &path, float *r_progress, Ref<Resource> *r_resource);
+	static void _release_request(const String &path);
+
+	static Mutex _shared_requests_lock;
+	static HashMap<String, SharedLoadRequest> _shared_requests;
+#endif
+
+private:
+	String _path;
+	String _type_hint;
+
+	ObjectID _requester;
+	bool _has_requester;
+
+	std::atomic<float> _progress;
+	Ref<Resource> _resource;
+
+#if VERSION_MAJOR < 4
+	Ref<ResourceInteractiveLoader> _loader;
+#else
+	bool _requested;
+#endif
+};
+
+#endif
@@ -0,0 +1,233 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_shared_array.h"
+
+#include "thread_pool_array_view.h"
+
+ThreadPoolSharedArray::ArrayType ThreadPoolSharedArray::get_array_type() const {
+	return _array_type;
+}
+
+int ThreadPoolSharedArray::size() const {
+	return _size;
+}
+
+void ThreadPoolSharedArray::create_floats(const int size) {
+	ERR_FAIL_COND(size < 0);
+
+	clear();
+
+	//Resized in place, so the buffer is never shared, and taking the pointer doesn't copy it
+	_floats.resize(size);
+	_lock_floats();
+}
+
+void ThreadPoolSharedArray::create_vector3s(const int size) {
+	ERR_FAIL_COND(size < 0);
+
+	clear();
+
+	_vector3s.resize(size);
+	_lock_vector3s();
+}
+
+void ThreadPoolSharedArray::set_floats(const FloatArray &array) {
+	clear();
+
+	_floats = array;
+	_lock_floats();
+}
+
+void ThreadPoolSharedArray::set_vector3s(const Vector3Array &array) {
+	clear();
+
+	_vector3s = array;
+	_lock_vector3s();
+}
+
+ThreadPoolSharedArray::FloatArray ThreadPoolSharedArray::take_floats() {
+	ERR_FAIL_COND_V(_array_type != ARRAY_TYPE_FLOAT, FloatArray());
+
+	FloatArray array = _floats;
+
+	//Drops every other reference, so the returned array is unique again
+	clear();
+
+	return array;
+}
+
+ThreadPoolSharedArray::Vector3Array ThreadPoolSharedArray::take_vector3s() {
+	ERR_FAIL_COND_V(_array_type != ARRAY_TYPE_VECTOR3, Vector3Array());
+
+	Vector3Array array = _vector3s;
+
+	clear();
+
+	return array;
+}
+
+Variant ThreadPoolSharedArray::get_value(const int index) const {
+	ERR_FAIL_INDEX_V(index, _size, Variant());
+
+	switch (_array_type) {
+		case ARRAY_TYPE_FLOAT:
+			return reinterpret_cast<const FloatArrayItem *>(_ptr)[index];
+		case ARRAY_TYPE_VECTOR3:
+			return reinterpret_cast<const Vector3 *>(_ptr)[index];
+		default:
+			break;
+	}
+
+	return Variant();
+}
+
+void ThreadPoolSharedArray::set_value(const int index, const Variant &value) {
+	ERR_FAIL_INDEX(index, _size);
+
+	switch (_array_type) {
+		case ARRAY_TYPE_FLOAT:
+			reinterpret_cast<FloatArrayItem *>(_ptr)[index] = value;
+			break;
+		case ARRAY_TYPE_VECTOR3:
+			reinterpret_cast<Vector3 *>(_ptr)[index] = value;
+			break;
+		default:
+			break;
+	}
+}
+
+Ref<ThreadPoolArrayView> ThreadPoolSharedArray::get_view(const int offset, const int size) {
+	ERR_FAIL_COND_V(offset < 0 || size < 0 || offset + size > _size, Ref<ThreadPoolArrayView>());
+
+	Ref<ThreadPoolArrayView> view = Ref<ThreadPoolArrayView>(memnew(ThreadPoolArrayView));
+	view->setup(Ref<ThreadPoolSharedArray>(this), offset, size);
+
+	return view;
+}
+
+Array ThreadPoolSharedArray::partition(const int count) {
+	Array views;
+
+	ERR_FAIL_COND_V(count <= 0, views);
+
+	int base_size = _size / count;
+	int remainder = _size % count;
+	int offset = 0;
+
+	for (int i = 0; i < count; ++i) {
+		int size = base_size + (i < remainder ? 1 : 0);
+
+		views.push_back(get_view(offset, size));
+
+		offset += size;
+	}
+
+	return views;
+}
+
+void *ThreadPoolSharedArray::ptrw() const {
+	return _ptr;
+}
+
+void ThreadPoolSharedArray::clear() {
+#if VERSION_MAJOR < 4
+	_floats_write.release();
+	_vector3s_write.release();
+#endif
+
+	_floats = FloatArray();
+	_vector3s = Vector3Array();
+
+	_array_type = ARRAY_TYPE_NONE;
+	_size = 0;
+	_ptr = NULL;
+}
+
+void ThreadPoolSharedArray::_lock_floats() {
+	_array_type = ARRAY_TYPE_FLOAT;
+	_size = _floats.size();
+
+	if (_size == 0) {
+		return;
+	}
+
+	//Getting a writable pointer copies the buffer, if it's still shared
+#if VERSION_MAJOR < 4
+	_floats_write = _floats.write();
+	_ptr = _floats_write.ptr();
+#else
+	_ptr = _floats.ptrw();
+#endif
+}
+
+void ThreadPoolSharedArray::_lock_vector3s() {
+	_array_type = ARRAY_TYPE_VECTOR3;
+	_size = _vector3s.size();
+
+	if (_size == 0) {
+		return;
+	}
+
+#if VERSION_MAJOR < 4
+	_vector3s_write = _vector3s.write();
+	_ptr = _vector3s_write.ptr();
+#else
+	_ptr = _vector3s.ptrw();
+#endif
+}
+
+ThreadPoolSharedArray::ThreadPoolSharedArray() {
+	_array_type = ARRAY_TYPE_NONE;
+	_size = 0;
+	_ptr = NULL;
+}
+
+ThreadPoolSharedArray::~ThreadPoolSharedArray() {
+	clear();
+}
+
+void ThreadPoolSharedArray::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("get_array_type"), &ThreadPoolSharedArray::get_array_type);
+	ClassDB::bind_method(D_METHOD("size"), &ThreadPoolSharedArray::size);
+
+	ClassDB::bind_method(D_METHOD("create_floats", "size"), &ThreadPoolSharedArray::create_floats);
+	ClassDB::bind_method(D_METHOD("create_vector3s", "size"), &ThreadPoolSharedArray::create_vector3s);
+
+	ClassDB::bind_method(D_METHOD("set_floats", "array"), &ThreadPoolSharedArray::set_floats);
+	ClassDB::bind_method(D_METHOD("set_vector3s", "array"), &ThreadPoolSharedArray::set_vector3s);
+
+	ClassDB::bind_method(D_METHOD("take_floats"), &ThreadPoolSharedArray::take_floats);
+	ClassDB::bind_method(D_METHOD("take_vector3s"), &ThreadPoolSharedArray::take_vector3s);
+
+	ClassDB::bind_method(D_METHOD("get_value", "index"), &ThreadPoolSharedArray::get_value);
+	ClassDB::bind_method(D_METHOD("set_value", "index", "value"), &ThreadPoolSharedArray::set_value);
+
+	ClassDB::bind_method(D_METHOD("get_view", "offset", "size"), &ThreadPoolSharedArray::get_view);
+	ClassDB::bind_method(D_METHOD("partition", "count"), &ThreadPoolSharedArray::partition);
+
+	ClassDB::bind_method(D_METHOD("clear"), &ThreadPoolSharedArray::clear);
+
+	BIND_ENUM_CONSTANT(ARRAY_TYPE_NONE);
+	BIND_ENUM_CONSTANT(ARRAY_TYPE_FLOAT);
+	BIND_ENUM_CONSTANT(ARRAY_TYPE_VECTOR3);
+}
@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_SHARED_ARRAY_H
+#define THREAD_POOL_SHARED_ARRAY_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/object/ref_counted.h"
+#include "core/variant/array.h"
+#ifndef Reference
+#define Reference RefCounted
+#endif
+#else
+#include "core/array.h"
+#include "core/reference.h"
+#endif
+
+class ThreadPoolArrayView;
+
+// Owns the only reference to a packed array's buffer, so jobs can read and write it in place
+// through ThreadPoolArrayViews, without copy on write kicking in.
+// Jobs must only touch their own view, and the array must not be changed or taken while they run.
+class ThreadPoolSharedArray : public Reference {
+	GDCLASS(ThreadPoolSharedArray, Reference);
+
+public:
+#if VERSION_MAJOR < 4
+	typedef PoolRealArray FloatArray;
+	typedef real_t FloatArrayItem;
+	typedef PoolVector3Array Vector3Array;
+#else
+	typedef PackedFloat32Array FloatArray;
+	typedef float FloatArrayItem;
+	typedef PackedVector3Array Vector3Array;
+#endif
+
+	enum ArrayType {
+		ARRAY_TYPE_NONE = 0,
+		ARRAY_TYPE_FLOAT,
+		ARRAY_TYPE_VECTOR3,
+	};
+
+	// The ArrayType that stores T elements, ARRAY_TYPE_NONE if none does
+	template <class T>
+	static ArrayType get_array_type_of() {
+		return ARRAY_TYPE_NONE;
+	}
+
+	ArrayType get_array_type() const;
+	int size() const;
+
+	// These don't copy
+	void create_floats(const int size);
+	void create_vector3s(const int size);
+
+	// These only copy, if the array is still referenced somewhere else
+	void set_floats(const FloatArray &array);
+	void set_vector3s(const Vector3Array &array);
+
+	// Hands the buffer back without copying, and clears this array. Views become invalid
+	FloatArray take_floats();
+	Vector3Array take_vector3s();
+
+	Variant get_value(const int index) const;
+	void set_value(const int index, const Variant &value);
+
+	Ref<ThreadPoolArrayView> get_view(const int offset, const int size);
+	// Splits the array into count views of (almost) the same size
+	Array partition(const int count);
+
+	// Raw pointer to the buffer, for C++ jobs. NULL if the array is empty
+	void *ptrw() const;
+
+	void clear();
+
+	ThreadPoolSharedArray();
+	~ThreadPoolSharedArray();
+
+protected:
+	static void _bind_methods();
+
+	void _lock_floats();
+	void _lock_vector3s();
+
+private:
+	ArrayType _array_type;
+	int _size;
+	void *_ptr;
+
+	FloatArray _floats;
+	Vector3Array _vector3s;
+
+#if VERSION_MAJOR < 4
+	//PoolVectors only give out pointers while locked
+	PoolRealArray::Write _floats_write;
+	PoolVector3Array::Write _vector3s_write;
+#endif
+};
+
+template <>
+inline ThreadPoolSharedArray::ArrayType ThreadPoolSharedArray::get_array_type_of<ThreadPoolSharedArray::FloatArrayItem>() {
+	return ARRAY_TYPE_FLOAT;
+}
+
+template <>
+inline ThreadPoolSharedArray::ArrayType ThreadPoolSharedArray::get_array_type_of<Vector3>() {
+	return ARRAY_TYPE_VECTOR3;
+}
+
+VARIANT_ENUM_CAST(ThreadPoolSharedArray::ArrayType);
+
+#endif
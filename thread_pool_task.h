@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_TASK_H
+#define THREAD_POOL_TASK_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/templates/safe_refcount.h"
+#else
+#include "core/safe_refcount.h"
+#endif
+
+#include "core/os/memory.h"
+
+#include <type_traits>
+#include <utility>
+
+// Slot for a native C++ task submitted using ThreadPool::submit().
+// Small callables are stored inline, bigger ones fall back to a heap allocation.
+// Slots are owned and recycled by the ThreadPool, they are never freed while it's alive.
+struct ThreadPoolTask {
+	enum {
+		INLINE_SIZE = 48,
+		INLINE_ALIGN = 16,
+	};
+
+	typedef void (*InvokeFunc)(void *callable);
+	typedef void (*DestroyFunc)(void *callable);
+
+	InvokeFunc invoke;
+	DestroyFunc destroy;
+	void *callable;
+
+	// Incremented every time a task finishes in this slot, futures compare against it
+	SafeNumeric<uint32_t> generation;
+
+	// Free list / queue link, owned by the ThreadPool
+	ThreadPoolTask *next;
+
+	alignas(INLINE_ALIGN) uint8_t storage[INLINE_SIZE];
+
+	template <class F>
+	void set(F &&f) {
+		typedef typename std::decay<F>::type FunctionType;
+
+		if (sizeof(FunctionType) <= INLINE_SIZE && alignof(FunctionType) <= INLINE_ALIGN) {
+			callable = memnew_placement(storage, FunctionType(std::forward<F>(f)));
+			destroy = &_destroy_inline<FunctionType>;
+		} else {
+			callable = memnew(FunctionType(std::forward<F>(f)));
+			destroy = &_destroy_heap<FunctionType>;
+		}
+
+		invoke = &_invoke<FunctionType>;
+	}
+
+	void run() {
+		invoke(callable);
+		destroy(callable);
+
+		callable = NULL;
+	}
+
+	// Destroys the callable without running it
+	void discard() {
+		if (callable) {
+			destroy(callable);
+			callable = NULL;
+		}
+	}
+
+	ThreadPoolTask() {
+		invoke = NULL;
+		destroy = NULL;
+		callable = NULL;
+		next = NULL;
+	}
+
+private:
+	template <class T>
+	static void _invoke(void *callable) {
+		(*reinterpret_cast<T *>(callable))();
+	}
+
+	template <class T>
+	static void _destroy_inline(void *callable) {
+		reinterpret_cast<T *>(callable)->~T();
+	}
+
+	template <class T>
+	static void _destroy_heap(void *callable) {
+		memdelete(reinterpret_cast<T *>(callable));
+	}
+};
+
+// Returned by ThreadPool::submit(). It's just a slot pointer and a generation, so it can be copied freely.
+class ThreadPoolTaskFuture {
+public:
+	bool is_valid() const {
+		return _task != NULL;
+	}
+
+	bool is_done() const {
+		return !_task || _task->generation.get() != _generation;
+	}
+
+	// Runs queued tasks on the calling thread while waiting, so it's safe to call from a job.
+	void wait() const;
+
+	ThreadPoolTaskFuture() {
+		_task = NULL;
+		_generation = 0;
+	}
+
+protected:
+	friend class ThreadPool;
+
+	ThreadPoolTaskFuture(ThreadPoolTask *task, const uint32_t generation) {
+		_task = task;
+		_generation = generation;
+	}
+
+private:
+	ThreadPoolTask *_task;
+	uint32_t _generation;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "thread_pool_timer_wheel.h"
+
+uint64_t ThreadPoolTimerWheel::get_current_tick() const {
+	return _current_tick;
+}
+
+int ThreadPoolTimerWheel::size() const {
+	return _size;
+}
+bool ThreadPoolTimerWheel::empty() const {
+	return _size == 0;
+}
+
+void ThreadPoolTimerWheel::add(const Ref<ThreadPoolJob> &job, const uint64_t expires, const uint64_t interval) {
+	ERR_FAIL_COND(!job.is_valid());
+
+	Timer timer;
+	timer.job = job;
+	timer.interval = interval;
+
+	//The slot of the current tick has already been processed
+	if (expires <= _current_tick) {
+		timer.expires = _current_tick + 1;
+	} else {
+		timer.expires = expires;
+	}
+
+	_insert(timer);
+
+	++_size;
+}
+
+bool ThreadPoolTimerWheel::remove(const Ref<ThreadPoolJob> &job) {
+	bool removed = false;
+
+	for (int i = 0; i < LEVEL_COUNT; ++i) {
+		for (int j = 0; j < SLOT_COUNT; ++j) {
+			List<Timer>::Element *E = _slots[i][j].front();
+
+			while (E) {
+				List<Timer>::Element *N = E->next();
+
+				if (E->get().job == job) {
+					_slots[i][j].erase(E);
+					--_size;
+					removed = true;
+				}
+
+				E = N;
+			}
+		}
+	}
+
+	return removed;
+}
+
+bool ThreadPoolTimerWheel::has(const Ref<ThreadPoolJob> &job) const {
+	for (int i = 0; i < LEVEL_COUNT; ++i) {
+		for (int j = 0; j < SLOT_COUNT; ++j) {
+			for (const List<Timer>::Element *E = _slots[i][j].front(); E; E = E->next()) {
+				if (E->get().job == job) {
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+uint64_t ThreadPoolTimerWheel::get_next_expiry() const {
+	uint64_t next = 0;
+
+	//Every timer keeps its exact expiry, so the levels don't have to be taken into account
+	for (int i = 0; i < LEVEL_COUNT; ++i) {
+		for (int j = 0; j < SLOT_COUNT; ++j) {
+			for (const List<Timer>::Element *E = _slots[i][j].front(); E; E = E->next()) {
+				if (next == 0 || E->get().expires < next) {
+					next = E->get().expires;
+				}
+			}
+		}
+	}
+
+	return next;
+}
+
+void ThreadPoolTimerWheel::advance(const uint64_t to_tick, List<Timer> *r_expired) {
+	ERR_FAIL_COND(!r_expired);
+
+	while (_current_tick < to_tick) {
+		if (_size == 0) {
+			_current_tick = to_tick;
+			return;
+		}
+
+		++_current_tick;
+
+		//Higher levels get moved down, when every level below them wrapped around
+		for (int level = 1; level < LEVEL_COUNT; ++level) {
+			uint64_t shift = SLOT_BITS * level;
+
+			if ((_current_tick & ((static_cast<uint64_t>(1) << shift) - 1)) != 0) {
+				break;
+			}
+
+			_cascade(level, (_current_tick >> shift) & SLOT_MASK);
+		}
+
+		List<Timer> &slot = _slots[0][_current_tick & SLOT_MASK];
+
+		while (slot.size() > 0) {
+			Timer timer = slot.front()->get();
+			slot.pop_front();
+			--_size;
+
+			if (timer.job->get_cancelled()) {
+				continue;
+			}
+
+			r_expired->push_back(timer);
+
+			if (timer.interval > 0) {
+				timer.expires += timer.interval;
+
+				if (timer.expires <= _current_tick) {
+					timer.expires = _current_tick + 1;
+				}
+
+				_insert(timer);
+				++_size;
+			}
+		}
+	}
+}
+
+void ThreadPoolTimerWheel::clear() {
+	for (int i = 0; i < LEVEL_COUNT; ++i) {
+		for (int j = 0; j < SLOT_COUNT; ++j) {
+			_slots[i][j].clear();
+		}
+	}
+
+	_size = 0;
+}
+
+void ThreadPoolTimerWheel::_insert(const Timer &timer) {
+	uint64_t delta = timer.expires - _current_tick;
+
+	for (int level = 0; level < LEVEL_COUNT; ++level) {
+		uint64_t shift = SLOT_BITS * (level + 1);
+
+		if (delta < (static_cast<uint64_t>(1) << shift)) {
+			int slot = (timer.expires >> (SLOT_BITS * level)) & SLOT_MASK;
+			_slots[level][slot].push_back(timer);
+			return;
+		}
+	}
+
+	//Too far in the future, park it in the farthest slot, it will get re-inserted when it cascades
+	uint64_t shift = SLOT_BITS * (LEVEL_COUNT - 1);
+	int slot = ((_current_tick >> shift) + SLOT_MASK) & SLOT_MASK;
+	_slots[LEVEL_COUNT - 1][slot].push_back(timer);
+}
+
+void ThreadPoolTimerWheel::_cascade(const int level, const int slot) {
+	List<Timer> &timers = _slots[level][slot];
+
+	while (timers.size() > 0) {
+		Timer timer = timers.front()->get();
+		timers.pop_front();
+
+		_insert(timer);
+	}
+}
+
+ThreadPoolTimerWheel::ThreadPoolTimerWheel() {
+	_current_tick = 0;
+	_size = 0;
+}
+
+ThreadPoolTimerWheel::~ThreadPoolTimerWheel() {
+	clear();
+}
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2019-2022 Péter Magyar
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_TIMER_WHEEL_H
+#define THREAD_POOL_TIMER_WHEEL_H
+
+#include "core/version.h"
+
+#if VERSION_MAJOR > 3
+#include "core/templates/list.h"
+#else
+#include "core/list.h"
+#endif
+
+#include "thread_pool_job.h"
+
+// Hierarchical timer wheel used by ThreadPool for delayed and repeating jobs.
+// Time is measured in ticks, the ThreadPool decides how long a tick is.
+// Not thread safe, the owner has to lock.
+class ThreadPoolTimerWheel {
+public:
+	enum {
+		SLOT_BITS = 6,
+		SLOT_COUNT = 1 << SLOT_BITS,
+		SLOT_MASK = SLOT_COUNT - 1,
+		LEVEL_COUNT = 4,
+	};
+
+	struct Timer {
+		Ref<ThreadPoolJob> job;
+		uint64_t expires;
+		uint64_t interval;
+
+		Timer() {
+			expires = 0;
+			interval = 0;
+		}
+	};
+
+	uint64_t get_current_tick() const;
+
+	int size() const;
+	bool empty() const;
+
+	void add(const Ref<ThreadPoolJob> &job, const uint64_t expires, const uint64_t interval);
+	bool remove(const Ref<ThreadPoolJob> &job);
+	bool has(const Ref<ThreadPoolJob> &job) const;
+
+	// Tick of the timer that expires first, 0 if the wheel is empty.
+	uint64_t get_next_expiry() const;
+
+	// Moves the wheel forward to to_tick, expired timers are appended to r_expired.
+	// Repeating timers are rescheduled automatically, unless their job got cancelled.
+	void advance(const uint64_t to_tick, List<Timer> *r_expired);
+
+	void clear();
+
+	ThreadPoolTimerWheel();
+	~ThreadPoolTimerWheel();
+
+protected:
+	void _insert(const Timer &timer);
+	void _cascade(const int level, const int slot);
+
+private:
+	List<Timer> _slots[LEVEL_COUNT][SLOT_COUNT];
+
+	uint64_t _current_tick;
+	int _size;
+};
+
+#endif